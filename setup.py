@@ -62,9 +62,25 @@ saturn = RelativeExtension(
     include_dirs=['lib/libsaturn/include'],
     libraries=['saturn'],
     library_dirs=[default_lib_dir, 'lib/libsaturn/lib'],
-    sources=['src/saturn.cpp', 'src/pydevice.cpp'],
-    extra_compile_args=compile_args,
-    extra_link_args=link_args
+    sources=[
+        'src/saturn.cpp',
+        'src/pydevice.cpp',
+        'src/runner.cpp',
+        'src/batch.cpp',
+        'src/trace.cpp',
+        'src/profiler.cpp',
+        'src/watch.cpp',
+        'src/dirty.cpp',
+        'src/realtime.cpp',
+        'src/background.cpp',
+        'src/interrupt_queue.cpp',
+        'src/generic_clock.cpp',
+        'src/generic_keyboard.cpp',
+        'src/lem1802.cpp',
+        'src/m35fd.cpp'
+    ],
+    extra_compile_args=compile_args + ['-pthread'],
+    extra_link_args=link_args + ['-pthread']
 )
 
 asteroid = RelativeExtension(
@@ -0,0 +1,83 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <cerrno>
+#include <system_error>
+#include <unistd.h>
+
+#include "background.hpp"
+
+background_run::background_run(galaxy::saturn::dcpu& cpu, const run_options& options)
+    : options(options), cancelled(false)
+{
+    if (options.breakpoints != NULL) {
+        breakpoints = *options.breakpoints;
+        this->options.breakpoints = &breakpoints;
+    }
+
+    if (options.skip_idle != NULL) {
+        devices = *options.skip_idle;
+        this->options.skip_idle = &devices;
+    }
+
+    this->options.cancel = &cancelled;
+
+    if (pipe(pipe_fds) < 0)
+        throw std::system_error(errno, std::system_category(), "pipe");
+
+    try {
+        worker = std::thread(&background_run::work, this, std::ref(cpu));
+    } catch (...) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        throw;
+    }
+}
+
+background_run::~background_run()
+{
+    if (worker.joinable()) {
+        cancel();
+        worker.join();
+    }
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+void background_run::work(galaxy::saturn::dcpu& cpu)
+{
+    result = run(cpu, options);
+
+    char done = 0;
+    while (write(pipe_fds[1], &done, 1) < 0 && errno == EINTR) {
+    }
+}
+
+run_result background_run::finish()
+{
+    if (worker.joinable())
+        worker.join();
+
+    return result;
+}
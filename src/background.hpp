@@ -0,0 +1,76 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef BACKGROUND_HPP
+#define BACKGROUND_HPP
+
+#include <libsaturn.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "runner.hpp"
+
+/**
+ * a native run on its own thread, which makes a file descriptor readable
+ * once it has finished so that an event loop can wait on it
+ */
+class background_run {
+public:
+    /**
+     * starts running `cpu`; the breakpoints and devices that `options`
+     * points to are copied, so they need not outlive the constructor.
+     * throws std::system_error if the pipe or thread can't be created
+     */
+    background_run(galaxy::saturn::dcpu& cpu, const run_options& options);
+
+    /// cancels the run if it is still going and waits for it
+    ~background_run();
+
+    /// the descriptor that becomes readable when the run is over
+    int fd() const { return pipe_fds[0]; }
+
+    /// asks the run to stop as soon as possible
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    /// waits for the run to finish, returning its result
+    run_result finish();
+
+private:
+    background_run(const background_run&);
+    background_run& operator=(const background_run&);
+
+    void work(galaxy::saturn::dcpu& cpu);
+
+    run_options options;
+    breakpoint_set breakpoints;
+    std::vector<native_device*> devices;
+
+    std::atomic<bool> cancelled;
+    run_result result;
+
+    int pipe_fds[2];
+    std::thread worker;
+};
+
+#endif
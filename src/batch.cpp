@@ -0,0 +1,106 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <libsaturn.hpp>
+#include "batch.hpp"
+
+/// the indices of the cpus still waiting to be run by one worker
+struct work_queue {
+    std::mutex lock;
+    std::deque<std::size_t> tasks;
+};
+
+/// takes the next task for worker `self`, stealing if its own queue is empty
+static bool take(std::vector<work_queue>& queues, std::size_t self, std::size_t& task)
+{
+    {
+        work_queue& own = queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // steal from the other end to the one the owner works from
+    for (std::size_t i = 1; i < queues.size(); i++) {
+        work_queue& victim = queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<run_result> run_batch(const std::vector<galaxy::saturn::dcpu*>& cpus,
+                                  const run_options& options, unsigned threads)
+{
+    std::vector<run_result> results(cpus.size());
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::size_t workers = std::min<std::size_t>(threads, cpus.size());
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < cpus.size(); i++) {
+            results[i] = run(*cpus[i], options);
+        }
+        return results;
+    }
+
+    std::vector<work_queue> queues(workers);
+    for (std::size_t i = 0; i < cpus.size(); i++) {
+        queues[i % workers].tasks.push_back(i);
+    }
+
+    auto worker = [&](std::size_t self) {
+        std::size_t task;
+        while (take(queues, self, task)) {
+            results[task] = run(*cpus[task], options);
+        }
+    };
+
+    // the calling thread is the first worker
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < workers; i++) {
+        pool.emplace_back(worker, i);
+    }
+
+    worker(0);
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    return results;
+}
@@ -0,0 +1,41 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <libsaturn.hpp>
+#include <vector>
+
+#include "runner.hpp"
+
+/**
+ * runs every cpu under the same options on up to `threads` worker threads
+ * (0 for one per core); each worker drains its own queue of cpus and then
+ * steals from the others. results are in the same order as `cpus`, which
+ * must be distinct and must not have python devices attached
+ */
+std::vector<run_result> run_batch(const std::vector<galaxy::saturn::dcpu*>& cpus,
+                                  const run_options& options, unsigned threads);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef DECODE_HPP
+#define DECODE_HPP
+
+#include <cstdint>
+
+/// operand code for the PC register
+const std::uint16_t OPERAND_PC = 0x1c;
+
+/// the lowest basic opcode that conditionally skips the next instruction
+const std::uint16_t OPCODE_IFB = 0x10;
+
+/// the highest basic opcode that conditionally skips the next instruction
+const std::uint16_t OPCODE_IFU = 0x17;
+
+/// the special opcodes that move PC, JSR and RFI
+const std::uint16_t SPECIAL_JSR = 0x01;
+const std::uint16_t SPECIAL_RFI = 0x0b;
+
+/**
+ * the fields of a raw instruction word, laid out as aaaaaabbbbbooooo
+ */
+struct instruction {
+    /// the basic opcode, or 0 for a special instruction
+    std::uint16_t opcode;
+
+    /// operand b, or the special opcode when `opcode` is 0
+    std::uint16_t b;
+
+    /// operand a
+    std::uint16_t a;
+};
+
+inline instruction decode(std::uint16_t word)
+{
+    instruction ins = {
+        static_cast<std::uint16_t>(word & 0x1f),
+        static_cast<std::uint16_t>((word >> 5) & 0x1f),
+        static_cast<std::uint16_t>(word >> 10)
+    };
+    return ins;
+}
+
+/// whether the operand is followed by a next word, e.g. [A+next] or PICK n
+inline bool uses_next_word(std::uint16_t operand)
+{
+    return (operand >= 0x10 && operand <= 0x17) || operand == 0x1a ||
+        operand == 0x1e || operand == 0x1f;
+}
+
+/// the number of words the instruction occupies, between 1 and 3
+inline std::uint16_t instruction_length(const instruction& ins)
+{
+    return 1 + uses_next_word(ins.a) + (ins.opcode != 0 && uses_next_word(ins.b));
+}
+
+/// whether the instruction unconditionally assigns to PC
+inline bool writes_pc(const instruction& ins)
+{
+    return ins.opcode != 0 && ins.b == OPERAND_PC &&
+        (ins.opcode < OPCODE_IFB || ins.opcode > OPCODE_IFU);
+}
+
+/// whether the instruction moves PC anywhere but past itself: a write to PC, JSR or RFI
+inline bool jumps(const instruction& ins)
+{
+    return writes_pc(ins) ||
+        (ins.opcode == 0 && (ins.b == SPECIAL_JSR || ins.b == SPECIAL_RFI));
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "dirty.hpp"
+
+/// the number of words compared with a single memcmp
+const std::size_t DIRTY_BLOCK_WORDS = 64;
+
+void diff_words(const std::uint16_t* a, const std::uint16_t* b,
+                std::size_t count, word_ranges& out)
+{
+    for (std::size_t block = 0; block < count; block += DIRTY_BLOCK_WORDS) {
+        std::size_t end = std::min(block + DIRTY_BLOCK_WORDS, count);
+
+        if (std::memcmp(a + block, b + block, (end - block) * sizeof(std::uint16_t)) == 0)
+            continue;
+
+        for (std::size_t i = block; i < end; i++) {
+            if (a[i] == b[i])
+                continue;
+
+            // runs carry on across block boundaries
+            if (!out.empty() && out.back().second == i) {
+                out.back().second++;
+            } else {
+                out.push_back(std::make_pair(std::uint32_t(i), std::uint32_t(i + 1)));
+            }
+        }
+    }
+}
+
+void dirty_tracker::take(const galaxy::saturn::dcpu& cpu, word_ranges& out)
+{
+    if (shadow.empty()) {
+        shadow.assign(cpu.ram.begin(), cpu.ram.end());
+        out.push_back(std::make_pair(std::uint32_t(0), std::uint32_t(shadow.size())));
+        return;
+    }
+
+    std::size_t first = out.size();
+    diff_words(cpu.ram.data(), shadow.data(), shadow.size(), out);
+
+    for (std::size_t i = first; i < out.size(); i++) {
+        std::copy(cpu.ram.begin() + out[i].first, cpu.ram.begin() + out[i].second,
+                  shadow.begin() + out[i].first);
+    }
+}
@@ -0,0 +1,59 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef DIRTY_HPP
+#define DIRTY_HPP
+
+#include <libsaturn.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// half-open [begin, end) ranges of word addresses
+typedef std::vector<std::pair<std::uint32_t, std::uint32_t> > word_ranges;
+
+/**
+ * appends the ranges where `a` and `b` differ to `out`, comparing a block
+ * at a time and only looking at single words inside blocks that differ
+ */
+void diff_words(const std::uint16_t* a, const std::uint16_t* b,
+                std::size_t count, word_ranges& out);
+
+/**
+ * finds the RAM that changed between calls by comparing against a copy
+ * taken on the previous call
+ */
+class dirty_tracker {
+public:
+    /**
+     * appends the ranges written since the last call to `out`, or the
+     * whole of RAM on the first call
+     */
+    void take(const galaxy::saturn::dcpu& cpu, word_ranges& out);
+
+private:
+    std::vector<std::uint16_t> shadow;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef DISPATCH_HPP
+#define DISPATCH_HPP
+
+#include <libsaturn.hpp>
+#include <cstdint>
+
+#include "decode.hpp"
+
+/// the registers a cycle starts from, which taking an interrupt marks
+struct cycle_start {
+    std::uint16_t pc;
+    std::uint16_t sp;
+    std::uint16_t a;
+    std::uint16_t ia;
+};
+
+inline cycle_start start_cycle(const galaxy::saturn::dcpu& cpu)
+{
+    cycle_start start = {cpu.PC, cpu.SP, cpu.A, cpu.IA};
+    return start;
+}
+
+/**
+ * guesses whether cycle() took a queued interrupt instead of running `ins`,
+ * the instruction at the old PC; libsaturn then pushes PC and A, jumps to
+ * IA and runs the handler's first instruction, all in the same call.
+ *
+ * This is only a guess from the words left below the old SP: the queue and
+ * the IAQ flag are private to libsaturn, and INT and native devices fill
+ * the queue without going through this tree. An instruction that pushes
+ * the same two words passes for a dispatch, and a handler that moves SP by
+ * two, or starts with RFI while `ins` jumps to itself, hides one. Nothing
+ * that has to be exact may depend on it.
+ */
+inline bool took_interrupt(const galaxy::saturn::dcpu& cpu,
+                           const cycle_start& start, const instruction& ins)
+{
+    if (start.ia == 0)
+        return false;
+
+    if (cpu.ram[static_cast<std::uint16_t>(start.sp - 1)] != start.pc ||
+            cpu.ram[static_cast<std::uint16_t>(start.sp - 2)] != start.a)
+        return false;
+
+    // two words pushed, give or take one moved by the handler
+    std::uint16_t pushed = start.sp - cpu.SP;
+    if (pushed >= 1 && pushed <= 3)
+        return true;
+
+    // a handler that starts with RFI puts every register back, leaving PC
+    // where an instruction that does not jump cannot
+    return pushed == 0 && cpu.PC == start.pc && !jumps(ins);
+}
+
+#endif
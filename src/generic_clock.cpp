@@ -0,0 +1,81 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <libsaturn.hpp>
+#include "generic_clock.hpp"
+
+void generic_clock::interrupt()
+{
+    switch (host->A) {
+        case 0:
+            divider = host->B;
+            ticks = 0;
+            phase = 0;
+            break;
+        case 1:
+            host->C = ticks;
+            break;
+        case 2:
+            message = host->B;
+            break;
+    }
+}
+
+void generic_clock::cycle()
+{
+    if (divider == 0)
+        return;
+
+    // a tick is due every rate * divider / 60 cycles
+    phase += 60;
+    if (phase >= (std::uint64_t)rate * divider) {
+        phase -= (std::uint64_t)rate * divider;
+        ticks++;
+
+        if (message != 0)
+            host->interrupt(message);
+    }
+}
+
+std::uint64_t generic_clock::quiet_cycles() const
+{
+    if (divider == 0 || message == 0)
+        return UINT64_MAX;
+
+    // the tick lands on the first cycle that takes phase to the period
+    std::uint64_t period = (std::uint64_t)rate * divider;
+    return (period - phase + 59) / 60 - 1;
+}
+
+void generic_clock::advance(std::uint64_t cycles)
+{
+    if (divider == 0)
+        return;
+
+    // split the cycles up so that 60 * cycles can't overflow
+    std::uint64_t period = (std::uint64_t)rate * divider;
+    std::uint64_t total = phase + 60 * (cycles % period);
+
+    ticks += 60 * (cycles / period) + total / period;
+    phase = total % period;
+}
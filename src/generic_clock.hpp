@@ -0,0 +1,61 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef GENERIC_CLOCK_HPP
+#define GENERIC_CLOCK_HPP
+
+#include <cstdint>
+#include "native_device.hpp"
+
+/**
+ * the generic clock, which ticks at 60Hz divided by a programmable value
+ */
+class generic_clock : public native_device {
+    protected:
+        /// the value the 60Hz base rate is divided by, or 0 when stopped
+        std::uint16_t divider;
+
+        /// the interrupt message sent on each tick, or 0 for none
+        std::uint16_t message;
+
+        /// sixtieths of a cycle accumulated towards the next tick
+        std::uint64_t phase;
+
+    public:
+        generic_clock(std::uint32_t rate = DCPU_CLOCK_RATE) :
+            native_device(0x12d0b402, 0, 1, "Generic Clock"),
+            divider(0), message(0), phase(0), ticks(0), rate(rate) {}
+
+        /// ticks since the clock was last started
+        std::uint16_t ticks;
+
+        /// the clock rate of the cpu the clock is attached to, in Hz
+        std::uint32_t rate;
+
+        virtual void interrupt();
+        virtual void cycle();
+        virtual std::uint64_t quiet_cycles() const;
+        virtual void advance(std::uint64_t cycles);
+};
+
+#endif
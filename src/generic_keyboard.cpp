@@ -0,0 +1,92 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <libsaturn.hpp>
+#include "generic_keyboard.hpp"
+
+void generic_keyboard::post(std::uint16_t key, bool pressed)
+{
+    key_event event = {key, pressed};
+
+    std::lock_guard<std::mutex> guard(pending_lock);
+    pending.push_back(event);
+    has_pending.store(true, std::memory_order_release);
+}
+
+void generic_keyboard::interrupt()
+{
+    switch (host->A) {
+        case 0:
+            buffer.clear();
+            break;
+        case 1:
+            if (buffer.empty()) {
+                host->C = 0;
+            } else {
+                host->C = buffer.front();
+                buffer.pop_front();
+            }
+            break;
+        case 2:
+            host->C = host->B < pressed.size() && pressed[host->B];
+            break;
+        case 3:
+            message = host->B;
+            break;
+    }
+}
+
+void generic_keyboard::cycle()
+{
+    if (!has_pending.load(std::memory_order_acquire))
+        return;
+
+    std::vector<key_event> events;
+    {
+        std::lock_guard<std::mutex> guard(pending_lock);
+        events.swap(pending);
+        has_pending.store(false, std::memory_order_relaxed);
+    }
+
+    for (auto& event : events) {
+        if (event.key < pressed.size())
+            pressed[event.key] = event.pressed;
+
+        if (event.pressed && buffer.size() < BUFFER_SIZE)
+            buffer.push_back(event.key);
+
+        if (message != 0)
+            host->interrupt(message);
+    }
+}
+
+std::uint64_t generic_keyboard::quiet_cycles() const
+{
+    return has_pending.load(std::memory_order_acquire) ? 0 : UINT64_MAX;
+}
+
+void generic_keyboard::advance(std::uint64_t cycles)
+{
+    // keys only arrive through post(), so there is nothing to catch up on
+    (void)cycles;
+}
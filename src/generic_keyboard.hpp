@@ -0,0 +1,91 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef GENERIC_KEYBOARD_HPP
+#define GENERIC_KEYBOARD_HPP
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "native_device.hpp"
+
+/// key codes for the keys that are not plain ASCII
+enum keyboard_key {
+    KEY_BACKSPACE = 0x10,
+    KEY_RETURN = 0x11,
+    KEY_INSERT = 0x12,
+    KEY_DELETE = 0x13,
+    KEY_UP = 0x80,
+    KEY_DOWN = 0x81,
+    KEY_LEFT = 0x82,
+    KEY_RIGHT = 0x83,
+    KEY_SHIFT = 0x90,
+    KEY_CONTROL = 0x91
+};
+
+/**
+ * the generic keyboard; key events are queued from python and reach the
+ * cpu on its next cycle
+ */
+class generic_keyboard : public native_device {
+    protected:
+        /// a key being pressed or released
+        struct key_event {
+            std::uint16_t key;
+            bool pressed;
+        };
+
+        /// events waiting to be seen by the cpu
+        std::vector<key_event> pending;
+        std::mutex pending_lock;
+        std::atomic<bool> has_pending;
+
+        /// typed keys that have not been read yet
+        std::deque<std::uint16_t> buffer;
+
+        std::bitset<0x100> pressed;
+
+        /// the interrupt message sent on each key event, or 0 for none
+        std::uint16_t message;
+
+    public:
+        /// the most keys the buffer holds before dropping new ones
+        static const std::size_t BUFFER_SIZE = 64;
+
+        generic_keyboard() : native_device(0x30cf7406, 0, 1, "Generic Keyboard"),
+            has_pending(false), message(0) {}
+
+        /// queues a key press or release; safe to call while the cpu runs
+        void post(std::uint16_t key, bool pressed);
+
+        virtual void interrupt();
+        virtual void cycle();
+        virtual std::uint64_t quiet_cycles() const;
+        virtual void advance(std::uint64_t cycles);
+};
+
+#endif
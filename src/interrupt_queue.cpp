@@ -0,0 +1,73 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include "interrupt_queue.hpp"
+
+const std::size_t interrupt_queue::CAPACITY;
+
+interrupt_queue::interrupt_queue()
+    : tail(0), head(0)
+{
+    for (std::size_t i = 0; i < CAPACITY; i++) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool interrupt_queue::push(std::uint16_t message)
+{
+    std::size_t pos = tail.load(std::memory_order_relaxed);
+    cell* target;
+
+    while (true) {
+        target = &cells[pos % CAPACITY];
+        std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t lap = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+
+        if (lap == 0) {
+            // the cell is free on this lap, so try to claim it
+            if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (lap < 0) {
+            // the consumer hasn't freed the cell from the last lap yet
+            return false;
+        } else {
+            pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    target->message = message;
+    target->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool interrupt_queue::pop(std::uint16_t& message)
+{
+    cell& source = cells[head % CAPACITY];
+    if (source.sequence.load(std::memory_order_acquire) != head + 1)
+        return false;
+
+    message = source.message;
+    source.sequence.store(head + CAPACITY, std::memory_order_release);
+    head++;
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef INTERRUPT_QUEUE_HPP
+#define INTERRUPT_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * a bounded lock-free queue of interrupt messages, which any number of
+ * threads can push to while a single thread at a time pops from it;
+ * after Dmitry Vyukov's bounded MPMC queue, with a plain consumer index
+ */
+class interrupt_queue {
+public:
+    /// the most messages that can be waiting, the same as the DCPU's own queue
+    static const std::size_t CAPACITY = 256;
+
+    interrupt_queue();
+
+    /// adds a message from any thread, returning false if the queue is full
+    bool push(std::uint16_t message);
+
+    /// takes the oldest message, if there is one; never called concurrently
+    bool pop(std::uint16_t& message);
+
+private:
+    interrupt_queue(const interrupt_queue&);
+    interrupt_queue& operator=(const interrupt_queue&);
+
+    struct cell {
+        /// which lap of the ring the cell is ready for
+        std::atomic<std::size_t> sequence;
+        std::uint16_t message;
+    };
+
+    cell cells[CAPACITY];
+
+    /// where the next message will be pushed
+    std::atomic<std::size_t> tail;
+
+    // the two ends are written by different threads, so keep them on
+    // separate cache lines; alignas isn't honoured by new before C++17
+    char padding[64];
+
+    /// where the next message will be popped from
+    std::size_t head;
+};
+
+#endif
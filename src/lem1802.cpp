@@ -0,0 +1,207 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+#include <libsaturn.hpp>
+#include "lem1802.hpp"
+
+/// blinking characters change state twice a second
+static const std::uint32_t BLINK_CYCLES = DCPU_CLOCK_RATE / 2;
+
+const std::uint16_t lem1802::default_font[lem1802::FONT_WORDS] = {
+    0xb79e, 0x388e, 0x722c, 0x75f4, 0x19bb, 0x7f8f, 0x85f9, 0xb158,
+    0x242e, 0x2400, 0x082a, 0x0800, 0x0008, 0x0000, 0x0808, 0x0808,
+    0x00ff, 0x0000, 0x00f8, 0x0808, 0x08f8, 0x0000, 0x080f, 0x0000,
+    0x000f, 0x0808, 0x00ff, 0x0808, 0x08f8, 0x0808, 0x08ff, 0x0000,
+    0x080f, 0x0808, 0x08ff, 0x0808, 0x6633, 0x99cc, 0x9933, 0x66cc,
+    0xfef8, 0xe080, 0x7f1f, 0x0701, 0x0107, 0x1f7f, 0x80e0, 0xf8fe,
+    0x5500, 0xaa00, 0x55aa, 0x55aa, 0xffaa, 0xff55, 0x0f0f, 0x0f0f,
+    0xf0f0, 0xf0f0, 0x0000, 0xffff, 0xffff, 0x0000, 0xffff, 0xffff,
+    0x0000, 0x0000, 0x005f, 0x0000, 0x0300, 0x0300, 0x3e14, 0x3e00,
+    0x266b, 0x3200, 0x611c, 0x4300, 0x3629, 0x7650, 0x0002, 0x0100,
+    0x1c22, 0x4100, 0x4122, 0x1c00, 0x1408, 0x1400, 0x081c, 0x0800,
+    0x4020, 0x0000, 0x0808, 0x0800, 0x0040, 0x0000, 0x601c, 0x0300,
+    0x3e49, 0x3e00, 0x427f, 0x4000, 0x6259, 0x4600, 0x2249, 0x3600,
+    0x0f08, 0x7f00, 0x2745, 0x3900, 0x3e49, 0x3200, 0x6119, 0x0700,
+    0x3649, 0x3600, 0x2649, 0x3e00, 0x0024, 0x0000, 0x4024, 0x0000,
+    0x0814, 0x2200, 0x1414, 0x1400, 0x2214, 0x0800, 0x0259, 0x0600,
+    0x3e59, 0x5e00, 0x7e09, 0x7e00, 0x7f49, 0x3600, 0x3e41, 0x2200,
+    0x7f41, 0x3e00, 0x7f49, 0x4100, 0x7f09, 0x0100, 0x3e41, 0x7a00,
+    0x7f08, 0x7f00, 0x417f, 0x4100, 0x2040, 0x3f00, 0x7f08, 0x7700,
+    0x7f40, 0x4000, 0x7f06, 0x7f00, 0x7f01, 0x7e00, 0x3e41, 0x3e00,
+    0x7f09, 0x0600, 0x3e61, 0x7e00, 0x7f09, 0x7600, 0x2649, 0x3200,
+    0x017f, 0x0100, 0x3f40, 0x7f00, 0x1f60, 0x1f00, 0x7f30, 0x7f00,
+    0x7708, 0x7700, 0x0778, 0x0700, 0x7149, 0x4700, 0x007f, 0x4100,
+    0x031c, 0x6000, 0x417f, 0x0000, 0x0201, 0x0200, 0x8080, 0x8000,
+    0x0001, 0x0200, 0x2454, 0x7800, 0x7f44, 0x3800, 0x3844, 0x2800,
+    0x3844, 0x7f00, 0x3854, 0x5800, 0x087e, 0x0900, 0x4854, 0x3c00,
+    0x7f04, 0x7800, 0x047d, 0x0000, 0x2040, 0x3d00, 0x7f10, 0x6c00,
+    0x017f, 0x0000, 0x7c18, 0x7c00, 0x7c04, 0x7800, 0x3844, 0x3800,
+    0x7c14, 0x0800, 0x0814, 0x7c00, 0x7c04, 0x0800, 0x4854, 0x2400,
+    0x043e, 0x4400, 0x3c40, 0x7c00, 0x1c60, 0x1c00, 0x7c30, 0x7c00,
+    0x6c10, 0x6c00, 0x4c50, 0x3c00, 0x6454, 0x4c00, 0x0836, 0x4100,
+    0x0077, 0x0000, 0x4136, 0x0800, 0x0201, 0x0201, 0x0205, 0x0200
+};
+
+const std::uint16_t lem1802::default_palette[lem1802::PALETTE_WORDS] = {
+    0x0000, 0x000a, 0x00a0, 0x00aa, 0x0a00, 0x0a0a, 0x0a50, 0x0aaa,
+    0x0555, 0x055f, 0x05f5, 0x05ff, 0x0f55, 0x0f5f, 0x0ff5, 0x0fff
+};
+
+/// copies `count` words into RAM at `address`, wrapping at the end of RAM
+static void dump(galaxy::saturn::dcpu& cpu, std::uint16_t address,
+                 const std::uint16_t* words, int count)
+{
+    for (int i = 0; i < count; i++) {
+        cpu.ram[(std::uint16_t)(address + i)] = words[i];
+    }
+}
+
+void lem1802::interrupt()
+{
+    switch (host->A) {
+        case 0:
+            screen = host->B;
+            break;
+        case 1:
+            font = host->B;
+            break;
+        case 2:
+            palette = host->B;
+            break;
+        case 3:
+            border = host->B & 0xf;
+            break;
+        case 4:
+            dump(*host, host->B, default_font, FONT_WORDS);
+            break;
+        case 5:
+            dump(*host, host->B, default_palette, PALETTE_WORDS);
+            break;
+    }
+}
+
+void lem1802::cycle()
+{
+    if (++blink_phase >= BLINK_CYCLES) {
+        blink_phase = 0;
+        blink = !blink;
+    }
+}
+
+bool lem1802::render(std::uint8_t* out, int channels, int border, bool force)
+{
+    const int cells = COLUMNS * ROWS;
+    const bool connected = host != NULL && screen != 0;
+
+    // gather the inputs to the frame, to tell whether it needs redrawing
+    std::vector<std::uint16_t> frame;
+    frame.reserve(cells + FONT_WORDS + PALETTE_WORDS + 5);
+    frame.push_back(connected);
+    frame.push_back(this->border);
+    frame.push_back(false);
+    frame.push_back(channels);
+    frame.push_back(border);
+
+    if (connected) {
+        bool blinking = false;
+        for (int i = 0; i < cells; i++) {
+            std::uint16_t cell = host->ram[(std::uint16_t)(screen + i)];
+            blinking |= (cell & 0x80) != 0;
+            frame.push_back(cell);
+        }
+
+        // the blink state only changes the picture when some cell blinks
+        frame[2] = blinking && blink;
+
+        for (int i = 0; i < FONT_WORDS; i++) {
+            frame.push_back(font ? host->ram[(std::uint16_t)(font + i)] : default_font[i]);
+        }
+
+        for (int i = 0; i < PALETTE_WORDS; i++) {
+            frame.push_back(palette ? host->ram[(std::uint16_t)(palette + i)] : default_palette[i]);
+        }
+    }
+
+    if (!force && frame == last_frame)
+        return false;
+
+    const std::uint16_t* cell_words = frame.data() + 5;
+    const std::uint16_t* font_words = cell_words + cells;
+    const std::uint16_t* palette_words = font_words + FONT_WORDS;
+
+    std::uint8_t colours[PALETTE_WORDS][4];
+    for (int i = 0; i < PALETTE_WORDS; i++) {
+        // each 4 bit channel of 0x0rgb is scaled up to 8 bits
+        std::uint16_t rgb = connected ? palette_words[i] : 0;
+        colours[i][0] = ((rgb >> 8) & 0xf) * 0x11;
+        colours[i][1] = ((rgb >> 4) & 0xf) * 0x11;
+        colours[i][2] = (rgb & 0xf) * 0x11;
+        colours[i][3] = 0xff;
+    }
+
+    const int width = WIDTH + 2 * border;
+    const int height = HEIGHT + 2 * border;
+
+    for (int y = 0; y < height; y++) {
+        std::uint8_t* pixel = out + (std::size_t)y * width * channels;
+
+        for (int x = 0; x < width; x++, pixel += channels) {
+            int cx = x - border, cy = y - border;
+            const std::uint8_t* colour = colours[this->border];
+
+            if (connected && cx >= 0 && cx < WIDTH && cy >= 0 && cy < HEIGHT) {
+                std::uint16_t cell = cell_words[(cy / CELL_HEIGHT) * COLUMNS + cx / CELL_WIDTH];
+                std::uint16_t glyph = font_words[(cell & 0x7f) * 2 + (cx % CELL_WIDTH) / 2];
+
+                // each glyph word holds two columns, the first in the high byte
+                std::uint8_t column = (cx % 2) ? glyph & 0xff : glyph >> 8;
+                bool lit = (column >> (cy % CELL_HEIGHT)) & 1;
+                if ((cell & 0x80) && !blink)
+                    lit = false;
+
+                colour = colours[lit ? cell >> 12 : (cell >> 8) & 0xf];
+            }
+
+            for (int c = 0; c < channels; c++) {
+                pixel[c] = colour[c];
+            }
+        }
+    }
+
+    last_frame.swap(frame);
+    return true;
+}
+
+std::uint64_t lem1802::quiet_cycles() const
+{
+    // blinking only changes what render() draws
+    return UINT64_MAX;
+}
+
+void lem1802::advance(std::uint64_t cycles)
+{
+    std::uint64_t total = blink_phase + cycles;
+    if ((total / BLINK_CYCLES) % 2)
+        blink = !blink;
+
+    blink_phase = total % BLINK_CYCLES;
+}
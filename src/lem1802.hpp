@@ -0,0 +1,93 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef LEM1802_HPP
+#define LEM1802_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "native_device.hpp"
+
+/**
+ * the NYA_ELEKTRISKA LEM1802 low energy monitor
+ */
+class lem1802 : public native_device {
+    protected:
+        /// cycles elapsed towards the next change of blink state
+        std::uint32_t blink_phase;
+
+        /// everything that went into the last rendered frame
+        std::vector<std::uint16_t> last_frame;
+
+    public:
+        /// the screen is 32x12 cells of 4x8 pixels
+        static const int COLUMNS = 32;
+        static const int ROWS = 12;
+        static const int CELL_WIDTH = 4;
+        static const int CELL_HEIGHT = 8;
+
+        static const int FONT_WORDS = 256;
+        static const int PALETTE_WORDS = 16;
+
+        static const std::uint16_t default_font[FONT_WORDS];
+        static const std::uint16_t default_palette[PALETTE_WORDS];
+
+        lem1802() : native_device(0x7349f615, 0x1c6c8b36, 0x1802, "LEM1802"),
+            blink_phase(0), screen(0), font(0), palette(0), border(0), blink(true) {}
+
+        /// where video RAM is mapped, or 0 when the screen is disconnected
+        std::uint16_t screen;
+
+        /// where font RAM is mapped, or 0 for the default font
+        std::uint16_t font;
+
+        /// where palette RAM is mapped, or 0 for the default palette
+        std::uint16_t palette;
+
+        /// the palette index of the border colour
+        std::uint16_t border;
+
+        /// whether blinking characters are currently shown
+        bool blink;
+
+        /// the width and height in pixels of the screen, without a border
+        static const int WIDTH = COLUMNS * CELL_WIDTH;
+        static const int HEIGHT = ROWS * CELL_HEIGHT;
+
+        /**
+         * rasterises the screen into `out`, an image with `channels` bytes per
+         * pixel (3 for RGB, 4 for RGBA) and a frame of `border` pixels on every
+         * side; when nothing has changed since the last call `out` is left
+         * alone and false is returned, unless `force` is set; it reads the
+         * host's RAM, so the host must not be running on another thread
+         */
+        bool render(std::uint8_t* out, int channels, int border, bool force);
+
+        virtual void interrupt();
+        virtual void cycle();
+        virtual std::uint64_t quiet_cycles() const;
+        virtual void advance(std::uint64_t cycles);
+};
+
+#endif
@@ -0,0 +1,154 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <algorithm>
+
+#include <libsaturn.hpp>
+#include "m35fd.hpp"
+
+void m35fd::notify()
+{
+    if (message != 0 && host != NULL)
+        host->interrupt(message);
+}
+
+void m35fd::set_state(std::uint16_t state)
+{
+    if (this->state != state) {
+        this->state = state;
+        notify();
+    }
+}
+
+void m35fd::set_error(std::uint16_t error)
+{
+    if (this->error != error) {
+        this->error = error;
+        notify();
+    }
+}
+
+void m35fd::insert(const std::uint16_t* words, std::size_t count, bool write_protected)
+{
+    disk.assign(SECTORS * SECTOR_WORDS, 0);
+    std::copy(words, words + std::min(count, disk.size()), disk.begin());
+
+    this->write_protected = write_protected;
+    set_state(write_protected ? STATE_READY_WP : STATE_READY);
+}
+
+void m35fd::eject()
+{
+    if (op != OP_NONE) {
+        op = OP_NONE;
+        set_error(ERROR_EJECT);
+    }
+
+    disk.clear();
+    set_state(STATE_NO_MEDIA);
+}
+
+bool m35fd::start(operation op)
+{
+    if (state == STATE_NO_MEDIA) {
+        set_error(ERROR_NO_MEDIA);
+        return false;
+    }
+
+    if (state == STATE_BUSY) {
+        set_error(ERROR_BUSY);
+        return false;
+    }
+
+    if (op == OP_WRITE && write_protected) {
+        set_error(ERROR_PROTECTED);
+        return false;
+    }
+
+    if (host->X >= SECTORS) {
+        set_error(ERROR_BAD_SECTOR);
+        return false;
+    }
+
+    this->op = op;
+    sector = host->X;
+    address = host->Y;
+
+    std::uint16_t target = sector / SECTORS_PER_TRACK;
+    remaining = TRANSFER_CYCLES + SEEK_CYCLES * (target > track ? target - track : track - target);
+    track = target;
+
+    set_state(STATE_BUSY);
+    return true;
+}
+
+void m35fd::interrupt()
+{
+    switch (host->A) {
+        case 0:
+            host->B = state;
+            host->C = error;
+            error = ERROR_NONE;
+            break;
+        case 1:
+            message = host->X;
+            break;
+        case 2:
+            host->B = start(OP_READ);
+            break;
+        case 3:
+            host->B = start(OP_WRITE);
+            break;
+    }
+}
+
+void m35fd::cycle()
+{
+    if (op == OP_NONE || --remaining != 0)
+        return;
+
+    std::vector<std::uint16_t>::iterator words = disk.begin() + sector * SECTOR_WORDS;
+    for (std::size_t i = 0; i < SECTOR_WORDS; i++) {
+        std::uint16_t at = address + i;
+        if (op == OP_READ) {
+            host->ram[at] = words[i];
+        } else {
+            words[i] = host->ram[at];
+        }
+    }
+
+    op = OP_NONE;
+    set_state(write_protected ? STATE_READY_WP : STATE_READY);
+}
+
+std::uint64_t m35fd::quiet_cycles() const
+{
+    // the transfer happens on the cycle that takes remaining to 0
+    return op == OP_NONE ? UINT64_MAX : remaining - 1;
+}
+
+void m35fd::advance(std::uint64_t cycles)
+{
+    if (op != OP_NONE)
+        remaining -= cycles;
+}
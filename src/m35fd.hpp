@@ -0,0 +1,115 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef M35FD_HPP
+#define M35FD_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "native_device.hpp"
+
+/**
+ * the Mackapar 3.5" floppy drive
+ */
+class m35fd : public native_device {
+    protected:
+        /// the operation the drive is busy with
+        enum operation {
+            OP_NONE,
+            OP_READ,
+            OP_WRITE
+        };
+
+        operation op;
+
+        /// the sector and RAM address of the current operation
+        std::uint16_t sector;
+        std::uint16_t address;
+
+        /// cycles left until the current operation completes
+        std::uint32_t remaining;
+
+        /// the track the head is over
+        std::uint16_t track;
+
+        /// the interrupt message sent on state and error changes, or 0 for none
+        std::uint16_t message;
+
+        void set_state(std::uint16_t state);
+        void set_error(std::uint16_t error);
+        void notify();
+
+        /// starts a read or write, returning whether it was accepted
+        bool start(operation op);
+
+    public:
+        enum drive_state {
+            STATE_NO_MEDIA = 0,
+            STATE_READY = 1,
+            STATE_READY_WP = 2,
+            STATE_BUSY = 3
+        };
+
+        enum drive_error {
+            ERROR_NONE = 0,
+            ERROR_BUSY = 1,
+            ERROR_NO_MEDIA = 2,
+            ERROR_PROTECTED = 3,
+            ERROR_EJECT = 4,
+            ERROR_BAD_SECTOR = 5,
+            ERROR_BROKEN = 0xffff
+        };
+
+        static const std::size_t SECTOR_WORDS = 512;
+        static const std::size_t SECTORS = 1440;
+        static const std::size_t SECTORS_PER_TRACK = 18;
+
+        /// reading or writing a sector streams 30700 words a second
+        static const std::uint32_t TRANSFER_CYCLES = SECTOR_WORDS * DCPU_CLOCK_RATE / 30700;
+
+        /// moving the head takes 2.4ms per track
+        static const std::uint32_t SEEK_CYCLES = DCPU_CLOCK_RATE * 24 / 10000;
+
+        m35fd() : native_device(0x4fd524c5, 0x1eb37e91, 0x000b, "M35FD"),
+            op(OP_NONE), sector(0), address(0), remaining(0), track(0), message(0),
+            state(STATE_NO_MEDIA), error(ERROR_NONE), write_protected(false) {}
+
+        std::uint16_t state;
+        std::uint16_t error;
+
+        /// the words on the inserted disk, empty when there is none
+        std::vector<std::uint16_t> disk;
+        bool write_protected;
+
+        /// inserts a disk holding `count` words, padded with zeroes
+        void insert(const std::uint16_t* words, std::size_t count, bool write_protected);
+        void eject();
+
+        virtual void interrupt();
+        virtual void cycle();
+        virtual std::uint64_t quiet_cycles() const;
+        virtual void advance(std::uint64_t cycles);
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef NATIVE_DEVICE_HPP
+#define NATIVE_DEVICE_HPP
+
+#include <libsaturn.hpp>
+#include <cstdint>
+#include <string>
+
+/// the nominal clock rate of the DCPU-16, in Hz
+const std::uint32_t DCPU_CLOCK_RATE = 100000;
+
+/**
+ * a base for devices implemented in C++, which never call into python and
+ * so can be run without the GIL
+ */
+class native_device : public galaxy::saturn::device {
+    public:
+        native_device(std::uint32_t id, std::uint32_t manufacturer,
+                      std::uint16_t version, std::string name) :
+            galaxy::saturn::device(id, manufacturer, version, name), host(NULL) {}
+
+        /// the cpu the device has been attached to, or NULL
+        galaxy::saturn::dcpu* host;
+
+        /**
+         * how many of the upcoming calls to cycle() are sure to neither
+         * interrupt the cpu nor touch its RAM, so that they can be replaced
+         * by advance(); UINT64_MAX when the device is waiting on nothing
+         */
+        virtual std::uint64_t quiet_cycles() const { return 0; }
+
+        /// does the work of that many quiet calls to cycle() at once
+        virtual void advance(std::uint64_t cycles) { (void)cycles; }
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef OPERAND_HPP
+#define OPERAND_HPP
+
+#include <libsaturn.hpp>
+#include <cstdint>
+
+/**
+ * works out the RAM address an operand refers to, if any, as it stands
+ * before the instruction runs; `next` is the operand's next word and
+ * `is_b` picks PUSH over POP for operand 0x18
+ */
+inline bool operand_address(const galaxy::saturn::dcpu& cpu,
+                            std::uint16_t operand, std::uint16_t next,
+                            bool is_b, std::uint16_t& address)
+{
+    const std::uint16_t registers[] = {
+        cpu.A, cpu.B, cpu.C, cpu.X, cpu.Y, cpu.Z, cpu.I, cpu.J
+    };
+
+    if (operand < 0x08)
+        return false;
+
+    if (operand < 0x10) {
+        address = registers[operand - 0x08];
+        return true;
+    }
+
+    if (operand < 0x18) {
+        address = registers[operand - 0x10] + next;
+        return true;
+    }
+
+    switch (operand) {
+    case 0x18:
+        address = is_b ? cpu.SP - 1 : cpu.SP;
+        return true;
+    case 0x19:
+        address = cpu.SP;
+        return true;
+    case 0x1a:
+        address = cpu.SP + next;
+        return true;
+    case 0x1e:
+        address = next;
+        return true;
+    default:
+        return false;
+    }
+}
+
+#endif
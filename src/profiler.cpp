@@ -0,0 +1,84 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <algorithm>
+
+#include "decode.hpp"
+#include "dispatch.hpp"
+#include "profiler.hpp"
+
+/// the base cost of each basic opcode, from the DCPU-16 1.7 spec
+static const std::uint8_t basic_cycles[0x20] = {
+    0, 1, 2, 2, 2, 2, 3, 3, 3, 3, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 0, 0, 2, 2
+};
+
+/// the base cost of each special opcode, from the DCPU-16 1.7 spec
+static const std::uint8_t special_cycles[0x20] = {
+    0, 3, 0, 0, 0, 0, 0, 0, 4, 1, 1, 3, 2, 0, 0, 0,
+    2, 4, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+profiler::profiler()
+{
+    reset();
+}
+
+void profiler::record(const galaxy::saturn::dcpu& cpu, const cycle_start& start,
+                      const instruction& ins)
+{
+    if (took_interrupt(cpu, start, ins)) {
+        // the handler's first instruction ran in place of `ins`
+        interrupts++;
+        count(start.ia, decode(cpu.ram[start.ia]));
+    } else {
+        count(start.pc, ins);
+    }
+}
+
+void profiler::count(std::uint16_t pc, const instruction& ins)
+{
+    std::uint16_t length = instruction_length(ins);
+
+    int slot;
+    unsigned cycles = length - 1;
+    if (ins.opcode != 0) {
+        slot = ins.opcode;
+        cycles += basic_cycles[ins.opcode];
+    } else {
+        slot = 0x20 + ins.b;
+        cycles += special_cycles[ins.b];
+    }
+
+    opcode_counts[slot]++;
+    opcode_cycles[slot] += cycles;
+    pc_counts[pc]++;
+}
+
+void profiler::reset()
+{
+    std::fill(opcode_counts, opcode_counts + OPCODE_SLOTS, 0);
+    std::fill(opcode_cycles, opcode_cycles + OPCODE_SLOTS, 0);
+    std::fill(pc_counts, pc_counts + PC_SLOTS, 0);
+    interrupts = 0;
+}
@@ -0,0 +1,76 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <libsaturn.hpp>
+#include <cstdint>
+
+#include "decode.hpp"
+#include "dispatch.hpp"
+
+/// basic opcodes take slots 0x00-0x1f, special opcodes 0x20-0x3f
+const int OPCODE_SLOTS = 0x40;
+
+/// one counter for every address
+const int PC_SLOTS = 0x10000;
+
+/**
+ * counters for where a cpu spends its time, updated after each instruction
+ */
+class profiler {
+public:
+    profiler();
+
+    /**
+     * counts the cycle that just ran from `start`, in which `ins` was about
+     * to run unless an interrupt was taken first
+     */
+    void record(const galaxy::saturn::dcpu& cpu, const cycle_start& start,
+                const instruction& ins);
+
+    /// zeroes every counter
+    void reset();
+
+    /// how many times each opcode was executed
+    std::uint64_t opcode_counts[OPCODE_SLOTS];
+
+    /// the cycles each opcode cost, per the spec, including next words
+    std::uint64_t opcode_cycles[OPCODE_SLOTS];
+
+    /// how many instructions were executed from each address
+    std::uint64_t pc_counts[PC_SLOTS];
+
+    /**
+     * roughly how many times the cpu entered its interrupt handler, going
+     * by took_interrupt(), which can miss a dispatch or see one that was not
+     */
+    std::uint64_t interrupts;
+
+private:
+    /// counts `ins`, executed from `pc`
+    void count(std::uint16_t pc, const instruction& ins);
+};
+
+#endif
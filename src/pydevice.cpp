@@ -23,21 +23,185 @@ file named "LICENSE-LGPL.txt".
 #include <Python.h>
 #include <libsaturn.hpp>
 #include "pydevice.hpp"
+#include "device_error.hpp"
+
+/// the callbacks' names, interned when the first device is bound
+static PyObject * interrupt_name = NULL;
+static PyObject * cycle_name = NULL;
+
+/**
+ * whether `dev`'s `name` attribute is something other than the `stub` method
+ * saturn.device defines, returning -1 with an exception set on failure
+ */
+static int overridden(PyObject & dev, PyObject * name, PyCFunction stub)
+{
+    PyObject * func = PyObject_GetAttr(&dev, name);
+    if (func == NULL) {
+        if (!PyErr_ExceptionMatches(PyExc_AttributeError))
+            return -1;
+
+        PyErr_Clear();
+        return 0;
+    }
+
+    bool inherited = PyCFunction_Check(func) && PyCFunction_GET_SELF(func) == &dev &&
+        PyCFunction_GET_FUNCTION(func) == stub;
+
+    Py_DECREF(func);
+    return !inherited;
+}
+
+int PyDevice::overrides(PyCFunction interrupt_stub, PyCFunction cycle_stub,
+                        bool & interrupt, bool & cycle) const
+{
+    if (interrupt_name == NULL) {
+        interrupt_name = PyUnicode_InternFromString("interrupt");
+        if (interrupt_name == NULL)
+            return -1;
+    }
+
+    if (cycle_name == NULL) {
+        cycle_name = PyUnicode_InternFromString("cycle");
+        if (cycle_name == NULL)
+            return -1;
+    }
+
+    int found = overridden(dev, interrupt_name, interrupt_stub);
+    if (found < 0)
+        return -1;
+    interrupt = found;
+
+    found = overridden(dev, cycle_name, cycle_stub);
+    if (found < 0)
+        return -1;
+    cycle = found;
+
+    return 0;
+}
+
+int PyDevice::bind(PyCFunction interrupt_stub, PyCFunction cycle_stub)
+{
+    return overrides(interrupt_stub, cycle_stub, has_interrupt, has_cycle);
+}
+
+thread_local gil_release * gil_release::current = NULL;
+
+gil_release::gil_release()
+    : acquisitions(0), outer(current)
+{
+    current = this;
+    saved = PyEval_SaveThread();
+}
+
+gil_release::~gil_release()
+{
+    PyEval_RestoreThread(saved);
+    current = outer;
+}
+
+gil_hold::gil_hold()
+    : run(gil_release::current)
+{
+    if (run == NULL || run->saved == NULL) {
+        run = NULL;
+        return;
+    }
+
+    PyEval_RestoreThread(run->saved);
+    run->saved = NULL;
+    run->acquisitions++;
+}
+
+gil_hold::~gil_hold()
+{
+    if (run != NULL)
+        run->saved = PyEval_SaveThread();
+}
+
+/// the cpu whose python device is running a callback on this thread
+static thread_local const galaxy::saturn::dcpu * caller = NULL;
+
+/// marks the device's cpu as stopped inside it while holding the GIL
+class device_call {
+        const galaxy::saturn::dcpu * outer;
+        gil_hold gil;
+
+    public:
+        device_call(const galaxy::saturn::dcpu * cpu) : outer(caller)
+        {
+            caller = cpu;
+        }
+
+        ~device_call()
+        {
+            caller = outer;
+        }
+};
+
+bool PyDevice::calling(const galaxy::saturn::dcpu * cpu)
+{
+    return cpu != NULL && caller == cpu;
+}
+
+void PyDevice::call(PyObject * name, PyObject * arg)
+{
+#if PY_VERSION_HEX >= 0x03090000
+    PyObject * args[] = {&dev, arg};
+    PyObject * ret = PyObject_VectorcallMethod(name, args, arg == NULL ? 1 : 2, NULL);
+#else
+    // a NULL arg ends the argument list early
+    PyObject * ret = PyObject_CallMethodObjArgs(&dev, name, arg, NULL);
+#endif
+
+    if (ret == NULL)
+        throw device_error();
+
+    Py_DECREF(ret);
+}
+
+void PyDevice::tick()
+{
+    PyObject * arg = PyLong_FromUnsignedLong(elapsed);
+    if (arg == NULL)
+        throw device_error();
+
+    elapsed = 0;
+
+    try {
+        call(cycle_name, arg);
+    } catch (device_error& e) {
+        Py_DECREF(arg);
+        throw;
+    }
+
+    Py_DECREF(arg);
+}
 
 void PyDevice::interrupt()
 {
-    PyObject * pfunc = PyObject_GetAttrString(&dev, "interrupt");
-    if (pfunc && PyCallable_Check(pfunc))
-        PyObject_CallObject(pfunc, NULL);
+    if (native())
+        return;
+
+    device_call scope(host);
+
+    // bring the device up to date before it looks at the registers
+    if (elapsed != 0 && has_cycle)
+        tick();
 
-    Py_XDECREF(pfunc);
+    if (has_interrupt)
+        call(interrupt_name);
 }
 
 void PyDevice::cycle()
 {
-    PyObject * pfunc = PyObject_GetAttrString(&dev, "cycle");
-    if (pfunc && PyCallable_Check(pfunc))
-        PyObject_CallObject(pfunc, NULL);
+    if (!has_cycle)
+        return;
 
-    Py_XDECREF(pfunc);
+    if (tick_period <= 1) {
+        device_call scope(host);
+        call(cycle_name);
+    } else if (++elapsed >= tick_period) {
+        device_call scope(host);
+        tick();
+    }
 }
@@ -27,6 +27,43 @@ file named "LICENSE-LGPL.txt".
 #include <libsaturn.hpp>
 #include <cstdint>
 
+/**
+ * lets go of the GIL for as long as a native run is in scope; python devices
+ * called on the same thread take it back only while their callbacks run
+ */
+class gil_release {
+    public:
+        gil_release();
+        ~gil_release();
+
+        /// how many times the GIL has been taken back during the run
+        std::uint64_t acquisitions;
+
+    private:
+        friend class gil_hold;
+
+        /// the thread state saved by the run, or NULL while the GIL is held
+        PyThreadState * saved;
+
+        /// the run this one was started from inside a device, if any
+        gil_release * outer;
+
+        /// the innermost run on this thread that let go of the GIL
+        static thread_local gil_release * current;
+};
+
+/**
+ * takes the GIL back from the innermost gil_release on this thread for as
+ * long as it is in scope; does nothing when the GIL is already held
+ */
+class gil_hold {
+        gil_release * run;
+
+    public:
+        gil_hold();
+        ~gil_hold();
+};
+
 /**
  * an interface for python devices
  */
@@ -34,9 +71,65 @@ class PyDevice : public galaxy::saturn::device {
     protected:
         PyObject & dev;
 
+        /// whether the device overrode interrupt() when it was last bound
+        bool has_interrupt;
+
+        /// whether the device overrode cycle() when it was last bound
+        bool has_cycle;
+
+        /// cycles that have passed since cycle() was last called
+        std::uint32_t elapsed;
+
+        /// calls the device's method `name`, looked up as python would
+        void call(PyObject * name, PyObject * arg = NULL);
+
+        /// hands the cycles that have built up to the python device
+        void tick();
+
     public:
         /// the PyDevice will wrap the dev python object
-        PyDevice(PyObject & dev) : galaxy::saturn::device(0,0,0,""), dev(dev) {}
+        PyDevice(PyObject & dev) : galaxy::saturn::device(0,0,0,""), dev(dev),
+            has_interrupt(false), has_cycle(false), elapsed(0), tick_period(1),
+            host(NULL) {}
+
+        /**
+         * how many cycles pass between calls to the python cycle function;
+         * when greater than one, it is passed the number of elapsed cycles
+         */
+        std::uint32_t tick_period;
+
+        /// the cpu the device has been attached to, or NULL
+        galaxy::saturn::dcpu * host;
+
+        /**
+         * whether a callback of one of `cpu`'s python devices is running on
+         * this thread, in which case the cpu is stopped inside it
+         */
+        static bool calling(const galaxy::saturn::dcpu * cpu);
+
+        virtual ~PyDevice() {}
+
+        /**
+         * works out which of interrupt() and cycle() the device overrides,
+         * through the instance as an attribute lookup would, so that
+         * callbacks set on the instance or patched onto the class count;
+         * methods that are still the stubs `interrupt_stub` and
+         * `cycle_stub` inherited from saturn.device do not. Returns -1
+         * with an exception set on failure
+         */
+        int overrides(PyCFunction interrupt_stub, PyCFunction cycle_stub,
+                      bool & interrupt, bool & cycle) const;
+
+        /**
+         * records which callbacks the device overrides, so that the stubs
+         * are never called; the cpu does this when the device is attached
+         * and before every run, so callbacks added in between are picked
+         * up by the next run
+         */
+        int bind(PyCFunction interrupt_stub, PyCFunction cycle_stub);
+
+        /// whether bind() found no python callbacks, so the device never needs the GIL
+        bool native() const { return !has_interrupt && !has_cycle; }
 
         virtual void interrupt();
         virtual void cycle();
@@ -0,0 +1,87 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <algorithm>
+
+#include "realtime.hpp"
+
+/// the cycles run per batch, as a fraction of a second
+const std::uint32_t SLICES_PER_SECOND = 1000;
+
+/// how far behind schedule a run may fall, as a fraction of a second
+const std::uint32_t MAX_LAG_FRACTION = 10;
+
+realtime_pacer::realtime_pacer(std::uint32_t hz, double duration)
+    : hz(hz), total(static_cast<std::uint64_t>(duration * hz)),
+      slice(std::max<std::uint64_t>(hz / SLICES_PER_SECOND, 1)),
+      start(clock::now())
+{
+    max_behind = std::max<std::uint64_t>(hz / MAX_LAG_FRACTION, slice);
+    stats.cycles = stats.slices = stats.catch_ups = stats.dropped = 0;
+    stats.max_lag = 0;
+}
+
+std::uint64_t realtime_pacer::due()
+{
+    std::uint64_t scheduled = std::min(
+        static_cast<std::uint64_t>(elapsed() * hz), total);
+    std::uint64_t accounted = stats.cycles + stats.dropped;
+    if (scheduled <= accounted)
+        return 0;
+
+    std::uint64_t behind = scheduled - accounted;
+    stats.max_lag = std::max(stats.max_lag, double(behind) / hz);
+
+    // wait for a whole slice, unless it's the end of the run
+    if (behind < slice && scheduled < total)
+        return 0;
+
+    if (behind > max_behind) {
+        stats.dropped += behind - max_behind;
+        behind = max_behind;
+    }
+
+    // oversleeping by a little is normal, so only count a real backlog
+    stats.slices++;
+    if (behind >= 2 * slice)
+        stats.catch_ups++;
+
+    return behind;
+}
+
+void realtime_pacer::ran(std::uint64_t cycles)
+{
+    stats.cycles += cycles;
+}
+
+realtime_pacer::clock::time_point realtime_pacer::next_slice() const
+{
+    std::uint64_t next = std::min(stats.cycles + stats.dropped + slice, total);
+    return start + std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(double(next) / hz));
+}
+
+double realtime_pacer::elapsed() const
+{
+    return std::chrono::duration<double>(clock::now() - start).count();
+}
@@ -0,0 +1,93 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef REALTIME_HPP
+#define REALTIME_HPP
+
+#include <chrono>
+#include <cstdint>
+
+/// how a paced run kept up with its target clock rate
+struct realtime_stats {
+    /// the cycles actually executed
+    std::uint64_t cycles;
+
+    /// the number of batches the cycles were executed in
+    std::uint64_t slices;
+
+    /// the batches that ran at least two slices' worth to catch up
+    std::uint64_t catch_ups;
+
+    /// the cycles given up on to keep the lag bounded
+    std::uint64_t dropped;
+
+    /// the furthest behind schedule the run fell, in seconds
+    double max_lag;
+};
+
+/**
+ * works out how many cycles are due against a monotonic clock, so that a
+ * cpu run in batches averages out at `hz`
+ */
+class realtime_pacer {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    realtime_pacer(std::uint32_t hz, double duration);
+
+    /// whether every cycle in the duration has been run or dropped
+    bool done() const { return stats.cycles + stats.dropped >= total; }
+
+    /**
+     * the number of cycles to run now, 0 when less than a slice is due;
+     * if the run has fallen more than MAX_LAG behind, the excess is dropped
+     */
+    std::uint64_t due();
+
+    /// records that `cycles` of the due cycles were run
+    void ran(std::uint64_t cycles);
+
+    /// when the next slice will be due
+    clock::time_point next_slice() const;
+
+    /// the seconds since the pacer was created
+    double elapsed() const;
+
+    realtime_stats stats;
+
+private:
+    std::uint32_t hz;
+
+    /// the cycles the whole duration is worth
+    std::uint64_t total;
+
+    /// the cycles run per batch when keeping up, about a millisecond's worth
+    std::uint64_t slice;
+
+    /// the furthest behind the run may fall before cycles are dropped
+    std::uint64_t max_behind;
+
+    clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,244 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <libsaturn.hpp>
+#include <invalid_opcode.hpp>
+#include <queue_overflow.hpp>
+
+#include <algorithm>
+
+#include "decode.hpp"
+#include "device_error.hpp"
+#include "dispatch.hpp"
+#include "runner.hpp"
+
+/// the longest loop, in words, that skip_idle will look for
+const std::uint16_t IDLE_LOOP_WORDS = 16;
+
+/**
+ * whether the words from `start` up to the backwards jump at `end` can only
+ * spin until something outside the cpu changes: conditionals followed by a
+ * SET, ADD or SUB of PC, none of them touching SP or writing anything but PC
+ * and EX
+ */
+static bool is_idle_loop(const galaxy::saturn::dcpu& cpu, std::uint16_t start,
+                         std::uint16_t end)
+{
+    if (static_cast<std::uint16_t>(end - start) >= IDLE_LOOP_WORDS)
+        return false;
+
+    std::uint16_t address = start;
+    while (true) {
+        instruction ins = decode(cpu.ram[address]);
+
+        // PUSH and POP move SP on every pass
+        if (ins.opcode == 0 || ins.a == 0x18 || ins.b == 0x18)
+            return false;
+
+        if (address == end) {
+            return writes_pc(ins) && ins.opcode <= 0x03;
+        }
+
+        if (ins.opcode < OPCODE_IFB || ins.opcode > OPCODE_IFU)
+            return false;
+
+        address += instruction_length(ins);
+        if (static_cast<std::uint16_t>(address - start) > static_cast<std::uint16_t>(end - start))
+            return false;
+    }
+}
+
+/// how many cycles the devices can all be fast-forwarded without an event
+static std::uint64_t quiet_cycles(const std::vector<native_device*>& devices)
+{
+    std::uint64_t quiet = UINT64_MAX;
+    for (std::size_t i = 0; i < devices.size(); i++) {
+        quiet = std::min(quiet, devices[i]->quiet_cycles());
+    }
+
+    return quiet;
+}
+
+/// how often run_plain looks at the cancel flag and interrupt queue, in cycles
+const std::uint64_t POLL_CYCLES = 1024;
+
+/// whether another thread has asked the run to stop
+static bool cancelled(const run_options& options)
+{
+    return options.cancel != NULL && options.cancel->load(std::memory_order_relaxed);
+}
+
+/**
+ * moves interrupts injected by other threads into the cpu's own queue,
+ * which throws queue_overflow when it is full
+ */
+static void deliver_interrupts(galaxy::saturn::dcpu& cpu, const run_options& options)
+{
+    if (options.interrupts == NULL)
+        return;
+
+    std::uint16_t message;
+    while (options.interrupts->pop(message)) {
+        cpu.interrupt(message);
+    }
+}
+
+/// the loop for runs with nothing to check between instructions
+static void run_plain(galaxy::saturn::dcpu& cpu, const run_options& options,
+                      run_result& result)
+{
+    while (result.cycles < options.cycles) {
+        if (cancelled(options)) {
+            result.reason = STOP_CANCELLED;
+            break;
+        }
+
+        deliver_interrupts(cpu, options);
+
+        std::uint64_t end = result.cycles +
+            std::min(options.cycles - result.cycles, POLL_CYCLES);
+        while (result.cycles < end) {
+            cpu.cycle();
+            result.cycles++;
+        }
+    }
+}
+
+/**
+ * the loop for runs with breakpoints, idle detection, tracing, profiling
+ * or watchpoints, which decodes each instruction once for all of them
+ */
+static void run_hooked(galaxy::saturn::dcpu& cpu, const run_options& options,
+                       run_result& result)
+{
+    // the idle loop last jumped back through, the cycle count at the time,
+    // and whether every instruction since has been inside it
+    std::uint16_t loop_start = 0, loop_end = 0;
+    std::uint64_t loop_cycles = 0, loop_quiet = 0;
+    bool in_loop = false;
+
+    while (result.cycles < options.cycles) {
+        std::uint16_t pc = cpu.PC;
+
+        if (cancelled(options)) {
+            result.reason = STOP_CANCELLED;
+            break;
+        }
+
+        // a run resumed from a breakpoint steps off it first
+        if (options.breakpoints != NULL && result.cycles != 0 &&
+                (*options.breakpoints)[pc]) {
+            result.reason = STOP_BREAKPOINT;
+            break;
+        }
+
+        deliver_interrupts(cpu, options);
+
+        instruction ins = decode(cpu.ram[pc]);
+
+        if (options.trace != NULL)
+            options.trace->record(cpu, ins);
+
+        bool hit = options.watches != NULL &&
+            options.watches->match(cpu, ins, result.watch);
+
+        cycle_start start = start_cycle(cpu);
+        cpu.cycle();
+        result.cycles++;
+
+        if (options.profile != NULL)
+            options.profile->record(cpu, start, ins);
+
+        if (hit) {
+            result.watch.new_value = cpu.ram[result.watch.address];
+            result.reason = STOP_WATCHPOINT;
+            break;
+        }
+
+        if (options.stop_on_idle && cpu.PC == pc && writes_pc(ins)) {
+            result.reason = STOP_IDLE;
+            break;
+        }
+
+        if (options.skip_idle == NULL)
+            continue;
+
+        if (in_loop && (static_cast<std::uint16_t>(pc - loop_start) >
+                        static_cast<std::uint16_t>(loop_end - loop_start))) {
+            in_loop = false;
+        }
+
+        if (!writes_pc(ins) || static_cast<std::uint16_t>(pc - cpu.PC) >= IDLE_LOOP_WORDS)
+            continue;
+
+        if (in_loop && loop_start == cpu.PC && loop_end == pc &&
+                result.cycles - loop_cycles <= loop_quiet) {
+            // a whole pass went by with no device acting, so every pass
+            // until one does will be the same; skip them all at once
+            std::uint64_t pass = result.cycles - loop_cycles;
+            std::uint64_t skip = std::min(quiet_cycles(*options.skip_idle),
+                                          options.cycles - result.cycles);
+            skip -= skip % pass;
+
+            for (std::size_t i = 0; i < options.skip_idle->size(); i++) {
+                (*options.skip_idle)[i]->advance(skip);
+            }
+
+            result.cycles += skip;
+            result.skipped += skip;
+        }
+
+        in_loop = is_idle_loop(cpu, cpu.PC, pc);
+        loop_start = cpu.PC;
+        loop_end = pc;
+        loop_cycles = result.cycles;
+        loop_quiet = in_loop ? quiet_cycles(*options.skip_idle) : 0;
+    }
+}
+
+run_result run(galaxy::saturn::dcpu& cpu, const run_options& options)
+{
+    run_result result = {0, STOP_BUDGET, 0, {0, 0, 0, 0}, 0, 0};
+
+    bool hooked = options.breakpoints != NULL || options.stop_on_idle ||
+        options.trace != NULL || options.profile != NULL ||
+        options.watches != NULL || options.skip_idle != NULL;
+
+    // a single try block for the whole run, rather than one per cycle
+    try {
+        if (hooked) {
+            run_hooked(cpu, options, result);
+        } else {
+            run_plain(cpu, options, result);
+        }
+    } catch (galaxy::saturn::invalid_opcode& e) {
+        result.reason = STOP_INVALID_OPCODE;
+    } catch (galaxy::saturn::queue_overflow& e) {
+        result.reason = STOP_QUEUE_OVERFLOW;
+    } catch (device_error& e) {
+        result.reason = STOP_DEVICE_ERROR;
+    }
+
+    result.pc = cpu.PC;
+    return result;
+}
@@ -0,0 +1,123 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef RUNNER_HPP
+#define RUNNER_HPP
+
+#include <libsaturn.hpp>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "interrupt_queue.hpp"
+#include "native_device.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+#include "watch.hpp"
+
+/// why a native run came to an end
+enum stop_reason {
+    STOP_BUDGET = 0,     ///< the requested number of cycles was executed
+    STOP_INVALID_OPCODE, ///< the cpu hit an invalid opcode
+    STOP_QUEUE_OVERFLOW, ///< the interrupt queue overflowed
+    STOP_BREAKPOINT,     ///< PC reached a breakpoint
+    STOP_IDLE,           ///< the cpu is spinning on a jump to itself
+    STOP_DEVICE_ERROR,   ///< a python device raised an exception
+    STOP_WATCHPOINT,     ///< an instruction accessed a watched address
+    STOP_CANCELLED       ///< the run was cancelled from another thread
+};
+
+/// the set of addresses a run should stop at
+typedef std::bitset<0x10000> breakpoint_set;
+
+/// the conditions under which a native run stops
+struct run_options {
+    /// the maximum number of cycles to execute
+    std::uint64_t cycles;
+
+    /// addresses to stop at before executing, or NULL for none
+    const breakpoint_set* breakpoints;
+
+    /// stop once an instruction jumps back onto itself
+    bool stop_on_idle;
+
+    /// where to record each instruction before it runs, or NULL for none
+    trace_buffer* trace;
+
+    /// the counters to update after each instruction, or NULL for none
+    profiler* profile;
+
+    /// addresses to stop after accessing, or NULL for none
+    const watch_set* watches;
+
+    /**
+     * every device attached to the cpu, all of them native, when idle
+     * loops should be fast-forwarded to the next device event; NULL when
+     * they should be run cycle by cycle
+     */
+    const std::vector<native_device*>* skip_idle;
+
+    /// a flag another thread can set to stop the run, or NULL for none
+    const std::atomic<bool>* cancel;
+
+    /// interrupts from other threads, handed to the cpu between instructions
+    interrupt_queue* interrupts;
+};
+
+/// options for a run of up to `cycles` cycles, with everything else off
+inline run_options run_for(std::uint64_t cycles)
+{
+    // value-initialised, so that fields added later start out zeroed too
+    run_options options = run_options();
+    options.cycles = cycles;
+    return options;
+}
+
+/// the outcome of a native run
+struct run_result {
+    /// the number of cycles that were actually executed
+    std::uint64_t cycles;
+
+    stop_reason reason;
+
+    /// the value of PC when the run stopped
+    std::uint16_t pc;
+
+    /// the access that stopped the run, for STOP_WATCHPOINT
+    watch_hit watch;
+
+    /// how many of the cycles were fast-forwarded through idle loops
+    std::uint64_t skipped;
+
+    /// how many times python devices took the GIL back, counted by the caller
+    std::uint64_t gil_acquisitions;
+};
+
+/**
+ * cycles the cpu until one of the conditions in `options` is met,
+ * without returning to python
+ */
+run_result run(galaxy::saturn::dcpu& cpu, const run_options& options);
+
+#endif
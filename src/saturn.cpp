@@ -23,25 +23,339 @@ file named "LICENSE-LGPL.txt".
 #include <Python.h>
 #include <structmember.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include <libsaturn.hpp>
 #include <invalid_opcode.hpp>
 #include <queue_overflow.hpp>
 
 #include "pydevice.hpp"
+#include "device_error.hpp"
+#include "decode.hpp"
+#include "runner.hpp"
+#include "native_device.hpp"
+#include "generic_clock.hpp"
+#include "generic_keyboard.hpp"
+#include "lem1802.hpp"
+#include "m35fd.hpp"
+#include "state.hpp"
+#include "batch.hpp"
+#include "trace.hpp"
+#include "profiler.hpp"
+#include "watch.hpp"
+#include "dirty.hpp"
+#include "interrupt_queue.hpp"
+#include "realtime.hpp"
+#include "background.hpp"
 
 static PyObject *InvalidOpcodeError;
 static PyObject *QueueOverflowError;
 
+/// array.array, used to hand out compact copies of RAM
+static PyObject *ArrayType;
+
+/// builds an array of the given typecode holding a copy of `size` bytes
+static PyObject *
+array_from_memory(const char *typecode, const void *data, Py_ssize_t size)
+{
+    PyObject *array = PyObject_CallFunction(ArrayType, "s", typecode);
+    if (array == NULL)
+        return NULL;
+
+    PyObject *view = PyMemoryView_FromMemory((char *)data, size, PyBUF_READ);
+    if (view == NULL) {
+        Py_DECREF(array);
+        return NULL;
+    }
+
+    PyObject *ret = PyObject_CallMethod(array, "frombytes", "O", view);
+    Py_DECREF(view);
+    if (ret == NULL) {
+        Py_DECREF(array);
+        return NULL;
+    }
+
+    Py_DECREF(ret);
+    return array;
+}
+
+/// builds an array('H') holding a copy of `count` words
+static PyObject *
+array_from_words(const std::uint16_t *words, Py_ssize_t count)
+{
+    return array_from_memory("H", words, count * sizeof(std::uint16_t));
+}
+
+/**
+ * works out whether a buffer format describes 16 bit integers, and if so
+ * whether they are in the opposite byte order to this machine
+ */
+static bool
+is_word_format(const char *format, bool& swap)
+{
+    if (format == NULL)
+        return false;
+
+    swap = false;
+    switch (*format) {
+        case '<':
+            swap = !PY_LITTLE_ENDIAN;
+            format++;
+            break;
+        case '>':
+        case '!':
+            swap = PY_LITTLE_ENDIAN;
+            format++;
+            break;
+        case '@':
+        case '=':
+            format++;
+            break;
+    }
+
+    return (format[0] == 'H' || format[0] == 'h') && format[1] == '\0';
+}
+
+/// how the items of a buffer are turned into words
+enum word_layout {
+    /// anything else, which is read as a sequence of integers instead
+    LAYOUT_SEQUENCE,
+    /// 16 bit integers, copied word for word
+    LAYOUT_WORDS,
+    /// unsigned bytes, one word per item
+    LAYOUT_BYTES
+};
+
+/**
+ * works out how a buffer's items become words, setting `swap` when 16 bit
+ * items are in the opposite byte order to this machine
+ */
+static word_layout
+layout_of(const Py_buffer& view, bool& swap)
+{
+    if (view.itemsize == 2 && is_word_format(view.format, swap))
+        return LAYOUT_WORDS;
+
+    if (view.itemsize == 1 && (view.format == NULL || std::strcmp(view.format, "B") == 0))
+        return LAYOUT_BYTES;
+
+    return LAYOUT_SEQUENCE;
+}
+
+/**
+ * checks the byteorder argument of an image, if one was given, setting
+ * `swap` when its raw words are in the opposite order to this machine
+ */
+static int
+parse_byteorder(const char *byteorder, PyObject *image, bool& swap)
+{
+    if (byteorder == NULL)
+        return 0;
+
+    if (std::strcmp(byteorder, "little") == 0) {
+        swap = !PY_LITTLE_ENDIAN;
+    } else if (std::strcmp(byteorder, "big") == 0) {
+        swap = PY_LITTLE_ENDIAN;
+    } else {
+        PyErr_SetString(PyExc_ValueError, "byteorder must be either 'little' or 'big'");
+        return -1;
+    }
+
+    if (!PyObject_CheckBuffer(image)) {
+        PyErr_SetString(PyExc_TypeError, "A byteorder can only be given for buffer arguments");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * takes a read-only view of a buffer, with its format, and points `data` at
+ * its items laid out contiguously; strided buffers like memoryview(a)[::2]
+ * are gathered into `copy`, anything else is used in place
+ */
+static int
+get_contiguous_buffer(PyObject *obj, Py_buffer *view, const void *&data, std::vector<char>& copy)
+{
+    if (PyObject_GetBuffer(obj, view, PyBUF_RECORDS_RO) < 0)
+        return -1;
+
+    if (PyBuffer_IsContiguous(view, 'C')) {
+        data = view->buf;
+        return 0;
+    }
+
+    copy.resize(view->len);
+    if (PyBuffer_ToContiguous(copy.data(), view, view->len, 'C') < 0) {
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    data = copy.data();
+    return 0;
+}
+
+/**
+ * copies exactly `count` words out of a buffer or a sequence of integers,
+ * reading buffers with the rules of flash(); returns -1 with an exception
+ * set on failure
+ */
+static int
+words_from_object(PyObject *value, std::uint16_t *out, Py_ssize_t count)
+{
+    if (PyObject_CheckBuffer(value)) {
+        Py_buffer view;
+        const void *data;
+        std::vector<char> copy;
+        if (get_contiguous_buffer(value, &view, data, copy) < 0)
+            return -1;
+
+        bool swap = false;
+        word_layout layout = layout_of(view, swap);
+
+        if (layout != LAYOUT_SEQUENCE) {
+            if (view.len != count * view.itemsize) {
+                PyBuffer_Release(&view);
+                PyErr_Format(PyExc_ValueError, "Expected exactly %zd words", count);
+                return -1;
+            }
+
+            if (layout == LAYOUT_WORDS) {
+                std::memcpy(out, data, view.len);
+                for (Py_ssize_t i = 0; swap && i < count; i++) {
+                    out[i] = (out[i] >> 8) | (out[i] << 8);
+                }
+            } else {
+                const unsigned char *bytes = (const unsigned char *)data;
+                std::copy(bytes, bytes + count, out);
+            }
+
+            PyBuffer_Release(&view);
+            return 0;
+        }
+
+        PyBuffer_Release(&view);
+    }
+
+    // anything else is converted to native words by array('H'), which
+    // checks that every item is an integer in range
+    PyObject *words = PyObject_CallFunction(ArrayType, "sO", "H", value);
+    if (words == NULL)
+        return -1;
+
+    Py_buffer view;
+    int status = PyObject_GetBuffer(words, &view, PyBUF_C_CONTIGUOUS);
+    Py_DECREF(words);
+    if (status < 0)
+        return -1;
+
+    if (view.len != (Py_ssize_t)(count * sizeof(std::uint16_t))) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "Expected exactly %zd words", count);
+        return -1;
+    }
+
+    std::memcpy(out, view.buf, view.len);
+    PyBuffer_Release(&view);
+    return 0;
+}
+
+static PyTypeObject RunResultType;
+
+static PyStructSequence_Field RunResult_fields[] = {
+    {const_cast<char *>("cycles"), const_cast<char *>("the number of cycles executed")},
+    {const_cast<char *>("reason"), const_cast<char *>("why the run stopped, one of the STOP_* constants")},
+    {const_cast<char *>("pc"), const_cast<char *>("the value of PC when the run stopped")},
+    {const_cast<char *>("address"), const_cast<char *>("the watched address that was accessed, or None")},
+    {const_cast<char *>("old"), const_cast<char *>("the watched word before the access, or None")},
+    {const_cast<char *>("new"), const_cast<char *>("the watched word after the access, or None")},
+    {const_cast<char *>("access_pc"), const_cast<char *>("the address of the instruction that made the access, or None")},
+    {const_cast<char *>("skipped"), const_cast<char *>("how many of the cycles were fast-forwarded through idle loops")},
+    {const_cast<char *>("gil_acquisitions"), const_cast<char *>("how many times python devices took the GIL during the run")},
+    {NULL}
+};
+
+static PyStructSequence_Desc RunResult_desc = {
+    const_cast<char *>("saturn.run_result"),
+    const_cast<char *>("the outcome of a native run"),
+    RunResult_fields,
+    2
+};
+
+static PyTypeObject RealtimeResultType;
+
+static PyStructSequence_Field RealtimeResult_fields[] = {
+    {const_cast<char *>("run"), const_cast<char *>("the run_result of the run as a whole")},
+    {const_cast<char *>("elapsed"), const_cast<char *>("the wall clock seconds the run took")},
+    {const_cast<char *>("slices"), const_cast<char *>("the number of batches the cycles were run in")},
+    {const_cast<char *>("catch_ups"), const_cast<char *>("the batches that had to run extra cycles to catch up")},
+    {const_cast<char *>("dropped"), const_cast<char *>("the cycles given up on to keep the lag bounded")},
+    {const_cast<char *>("max_lag"), const_cast<char *>("the furthest behind schedule the run fell, in seconds")},
+    {NULL}
+};
+
+static PyStructSequence_Desc RealtimeResult_desc = {
+    const_cast<char *>("saturn.realtime_result"),
+    const_cast<char *>("the outcome of a paced run"),
+    RealtimeResult_fields,
+    2
+};
+
+struct DCPU;
+
+/// defined with the dcpu type; devices use it to refuse changes mid-run
+static int
+DCPU_check_stopped(DCPU* self);
+
 struct Device {
     PyObject_HEAD
 
     /// the device the object is wrapping
     galaxy::saturn::device* hw;
+
+    /**
+     * the cpu object the device is attached to, or NULL; not a reference,
+     * since the cpu's devices list keeps the device alive and the cpu
+     * clears it when it goes away
+     */
+    DCPU *owner;
 };
 
+/// forgets the cpu the device was attached to, once that cpu is gone
+static void
+Device_detach(Device *self)
+{
+    native_device *native = dynamic_cast<native_device *>(self->hw);
+    if (native != NULL)
+        native->host = NULL;
+
+    PyDevice *pydev = dynamic_cast<PyDevice *>(self->hw);
+    if (pydev != NULL)
+        pydev->host = NULL;
+
+    self->owner = NULL;
+}
+
+/// refuses to change a device while the cpu it is attached to is running
+static int
+Device_check_stopped(Device *self)
+{
+    if (self->owner != NULL && DCPU_check_stopped(self->owner) < 0)
+        return -1;
+
+    return 0;
+}
+
 static void
 Device_dealloc(Device* self)
 {
+    // a cpu's devices list keeps every attached device alive, so no cpu
+    // can still be holding on to hw
+    delete self->hw;
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -51,18 +365,50 @@ Device_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     Device *self;
 
     self = (Device *)type->tp_alloc(type, 0);
+    if (self != NULL) {
+        // created here rather than in __init__, which subclasses may not call
+        self->hw = new PyDevice((PyObject &)*self);
+    }
+
+    return (PyObject *)self;
+}
+
+/// allocates a device object for the natively implemented `hw`, which it takes over
+static PyObject *
+Device_wrap(PyTypeObject *type, galaxy::saturn::device *hw)
+{
+    Device *self = (Device *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        delete hw;
+        return NULL;
+    }
 
+    self->hw = hw;
     return (PyObject *)self;
 }
 
+/**
+ * refuses to run __init__ again on an attached device, since its cpu holds
+ * on to the device being replaced
+ */
 static int
-Device_init(Device *self, PyObject *args, PyObject *kwds)
+Device_check_detached(Device *self)
 {
-    // init the device here because of magic
-    self->hw = (galaxy::saturn::device *)new PyDevice((PyObject &)*self);
+    if (self->owner != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "An attached device cannot be reinitialised");
+        return -1;
+    }
+
     return 0;
 }
 
+static int
+Device_init(Device *self, PyObject *args, PyObject *kwds)
+{
+    // the wrapped device already exists, so there is nothing to set up
+    return Device_check_detached(self);
+}
+
 static PyObject *
 Device_getid(Device *self, void *closure)
 {
@@ -191,6 +537,83 @@ Device_setname(Device *self, PyObject *value, void *closure)
     return 0;
 }
 
+static PyObject *
+Device_gettick_period(Device *self, void *closure)
+{
+    PyDevice *pydev = dynamic_cast<PyDevice *>(self->hw);
+    if (pydev == NULL) {
+        PyErr_SetString(PyExc_AttributeError, "Only python devices have a tick period");
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLong(pydev->tick_period);
+}
+
+static int
+Device_settick_period(Device *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the tick_period attribute");
+        return -1;
+    }
+
+    PyDevice *pydev = dynamic_cast<PyDevice *>(self->hw);
+    if (pydev == NULL) {
+        PyErr_SetString(PyExc_AttributeError, "Only python devices have a tick period");
+        return -1;
+    }
+
+    unsigned long period = PyLong_AsUnsignedLong(value);
+    if (period == (unsigned long)-1 && PyErr_Occurred())
+        return -1;
+
+    if (period < 1 || period > UINT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "The tick period must be a positive 32 bit integer");
+        return -1;
+    }
+
+    pydev->tick_period = period;
+
+    return 0;
+}
+
+static PyObject *
+Device_interrupt(Device* self)
+{
+    PyErr_SetString(PyExc_NotImplementedError, "Not implemented");
+    return NULL;
+}
+
+static PyObject *
+Device_cycle(Device* self, PyObject *args)
+{
+    PyErr_SetString(PyExc_NotImplementedError, "Not implemented");
+    return NULL;
+}
+
+/// records which of the stubs above a python device overrides
+static int
+Device_bind(PyDevice *pydev)
+{
+    return pydev->bind((PyCFunction)Device_interrupt, (PyCFunction)Device_cycle);
+}
+
+static PyObject *
+Device_getnative(Device *self, void *closure)
+{
+    PyDevice *pydev = dynamic_cast<PyDevice *>(self->hw);
+    if (pydev == NULL)
+        return PyBool_FromLong(dynamic_cast<native_device *>(self->hw) != NULL);
+
+    // looked up afresh, without disturbing what a running cpu has bound
+    bool interrupt, cycle;
+    if (pydev->overrides((PyCFunction)Device_interrupt, (PyCFunction)Device_cycle,
+                         interrupt, cycle) < 0)
+        return NULL;
+
+    return PyBool_FromLong(!interrupt && !cycle);
+}
+
 static PyGetSetDef Device_getseters[] = {
     {"id",
      (getter)Device_getid, (setter)Device_setid,
@@ -208,29 +631,26 @@ static PyGetSetDef Device_getseters[] = {
      (getter)Device_getname, (setter)Device_setname,
      "the name of the device",
      NULL},
+    {"tick_period",
+     (getter)Device_gettick_period, (setter)Device_settick_period,
+     "the number of cycles between calls to cycle(); when greater than 1, "
+     "cycle() is passed the number of elapsed cycles",
+     NULL},
+    {"native",
+     (getter)Device_getnative, NULL,
+     "whether the device never calls into python, so that a cpu with only "
+     "native devices can run without ever taking the GIL",
+     NULL},
     {NULL}  /* Sentinel */
 };
 
-static PyObject *
-Device_interrupt(Device* self)
-{
-    PyErr_SetString(PyExc_NotImplementedError, "Not implemented");
-    return NULL;
-}
-
-static PyObject *
-Device_cycle(Device* self)
-{
-    PyErr_SetString(PyExc_NotImplementedError, "Not implemented");
-    return NULL;
-}
-
 static PyMethodDef Device_methods[] = {
     {"interrupt", (PyCFunction)Device_interrupt, METH_NOARGS,
      "Send a hardware interrupt to the device"
     },
-    {"cycle", (PyCFunction)Device_cycle, METH_NOARGS,
-     "Triggered before each cycle of the DCPU"
+    {"cycle", (PyCFunction)Device_cycle, METH_VARARGS,
+     "Triggered before each cycle of the DCPU, or once every tick_period "
+     "cycles with the number of cycles that have elapsed"
     },
     {NULL} /* Sentinel */
 };
@@ -277,644 +697,3829 @@ static PyTypeObject DeviceType = {
     Device_new,                /* tp_new */
 };
 
-struct DCPU {
-    PyObject_HEAD
-
-    /// the cpu the object is wrapping
-    galaxy::saturn::dcpu* cpu;
-};
-
-static void
-DCPU_dealloc(DCPU* self)
-{
-    delete self->cpu;
-    Py_TYPE(self)->tp_free((PyObject*)self);
-}
+/// the generic clock, LEM1802, keyboard and M35FD implemented natively
 
 static PyObject *
-DCPU_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+Clock_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-    DCPU *self;
-
-    self = (DCPU *)type->tp_alloc(type, 0);
-    if (self != NULL) {
-        self->cpu = new galaxy::saturn::dcpu();
-    }
-
-    return (PyObject *)self;
+    return Device_wrap(type, new generic_clock(DCPU_CLOCK_RATE));
 }
 
 static int
-DCPU_init(DCPU *self, PyObject *args, PyObject *kwds)
-{
-    if (!PyArg_ParseTuple(args, ""))
-        return -1;
-
-    return 0;
-}
-
-static PyObject *
-DCPU_getA(DCPU *self, void *closure)
+Clock_init(Device *self, PyObject *args, PyObject *kwds)
 {
-    PyObject *A = PyLong_FromLong(self->cpu->A);
-    if (A == NULL) {
-        return NULL;
-    }
+    unsigned long rate = DCPU_CLOCK_RATE;
 
-    return A;
-}
+    static char *kwlist[] = {const_cast<char *>("rate"), NULL};
 
-static int
-DCPU_setA(DCPU *self, PyObject *value, void *closure)
-{
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|k", kwlist, &rate))
         return -1;
-    }
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
+    if (rate == 0 || rate > UINT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "The clock rate must be a positive 32 bit integer");
         return -1;
     }
 
-    self->cpu->A = PyLong_AsLong(value);
+    if (Device_check_detached(self) < 0)
+        return -1;
 
+    delete self->hw;
+    self->hw = new generic_clock(rate);
     return 0;
 }
 
 static PyObject *
-DCPU_getB(DCPU *self, void *closure)
+Clock_getticks(Device *self, void *closure)
 {
-    PyObject *B = PyLong_FromLong(self->cpu->B);
-    if (B == NULL) {
-        return NULL;
-    }
-
-    return B;
+    return PyLong_FromLong(static_cast<generic_clock *>(self->hw)->ticks);
 }
 
-static int
-DCPU_setB(DCPU *self, PyObject *value, void *closure)
+static PyObject *
+Clock_getrate(Device *self, void *closure)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
-        return -1;
-    }
-
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
-        return -1;
-    }
-
-    self->cpu->B = PyLong_AsLong(value);
-
-    return 0;
+    return PyLong_FromUnsignedLong(static_cast<generic_clock *>(self->hw)->rate);
 }
 
-static PyObject *
-DCPU_getC(DCPU *self, void *closure)
-{
-    PyObject *C = PyLong_FromLong(self->cpu->C);
-    if (C == NULL) {
-        return NULL;
-    }
+static PyGetSetDef Clock_getseters[] = {
+    {"ticks",
+     (getter)Clock_getticks, NULL,
+     "the number of ticks since the clock was last started",
+     NULL},
+    {"rate",
+     (getter)Clock_getrate, NULL,
+     "the clock rate of the cpu, in Hz",
+     NULL},
+    {NULL}  /* Sentinel */
+};
 
-    return C;
+static PyTypeObject ClockType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.clock",            /* tp_name */
+    sizeof(Device),            /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)Device_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+        Py_TPFLAGS_BASETYPE,   /* tp_flags */
+    "the generic clock, ticking at 60Hz / B", /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    0,                         /* tp_methods */
+    0,                         /* tp_members */
+    Clock_getseters,           /* tp_getset */
+    &DeviceType,               /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)Clock_init,      /* tp_init */
+    0,                         /* tp_alloc */
+    Clock_new,                 /* tp_new */
+};
+
+static PyObject *
+Keyboard_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    return Device_wrap(type, new generic_keyboard());
 }
 
 static int
-DCPU_setC(DCPU *self, PyObject *value, void *closure)
+Keyboard_init(Device *self, PyObject *args, PyObject *kwds)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+    if (!PyArg_ParseTuple(args, ""))
         return -1;
-    }
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
+    if (Device_check_detached(self) < 0)
         return -1;
-    }
-
-    self->cpu->C = PyLong_AsLong(value);
 
+    delete self->hw;
+    self->hw = new generic_keyboard();
     return 0;
 }
 
 static PyObject *
-DCPU_getX(DCPU *self, void *closure)
+Keyboard_press(Device *self, PyObject *args)
 {
-    PyObject *X = PyLong_FromLong(self->cpu->X);
-    if (X == NULL) {
+    std::uint16_t key;
+
+    if (!PyArg_ParseTuple(args, "H", &key))
         return NULL;
-    }
 
-    return X;
+    static_cast<generic_keyboard *>(self->hw)->post(key, true);
+
+    Py_RETURN_NONE;
 }
 
-static int
-DCPU_setX(DCPU *self, PyObject *value, void *closure)
+static PyObject *
+Keyboard_release(Device *self, PyObject *args)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
-        return -1;
-    }
+    std::uint16_t key;
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
-        return -1;
-    }
+    if (!PyArg_ParseTuple(args, "H", &key))
+        return NULL;
 
-    self->cpu->X = PyLong_AsLong(value);
+    static_cast<generic_keyboard *>(self->hw)->post(key, false);
 
-    return 0;
+    Py_RETURN_NONE;
 }
 
 static PyObject *
-DCPU_getY(DCPU *self, void *closure)
+Keyboard_type(Device *self, PyObject *args)
 {
-    PyObject *Y = PyLong_FromLong(self->cpu->Y);
-    if (Y == NULL) {
-        return NULL;
-    }
+    PyObject *text;
 
-    return Y;
-}
+    if (!PyArg_ParseTuple(args, "U", &text))
+        return NULL;
 
-static int
-DCPU_setY(DCPU *self, PyObject *value, void *closure)
-{
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
-        return -1;
+    Py_ssize_t length = PyUnicode_GetLength(text);
+    std::vector<std::uint16_t> keys(length);
+
+    // check all of the text before typing any of it
+    for (Py_ssize_t i = 0; i < length; i++) {
+        Py_UCS4 c = PyUnicode_ReadChar(text, i);
+
+        if (c == '\n') {
+            keys[i] = KEY_RETURN;
+        } else if (c == '\b') {
+            keys[i] = KEY_BACKSPACE;
+        } else if (c >= 0x20 && c < 0x7f) {
+            keys[i] = c;
+        } else {
+            PyErr_Format(PyExc_ValueError, "Cannot type character code %u", (unsigned int)c);
+            return NULL;
+        }
     }
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
-        return -1;
+    generic_keyboard *keyboard = static_cast<generic_keyboard *>(self->hw);
+    for (auto key : keys) {
+        keyboard->post(key, true);
+        keyboard->post(key, false);
     }
 
-    self->cpu->Y = PyLong_AsLong(value);
-
-    return 0;
+    Py_RETURN_NONE;
 }
 
+static PyMethodDef Keyboard_methods[] = {
+    {"press", (PyCFunction)Keyboard_press, METH_VARARGS,
+     "Press a key, typing it"
+    },
+    {"release", (PyCFunction)Keyboard_release, METH_VARARGS,
+     "Release a key"
+    },
+    {"type", (PyCFunction)Keyboard_type, METH_VARARGS,
+     "Press and release the key for each character of a string"
+    },
+    {NULL} /* Sentinel */
+};
+
+static PyTypeObject KeyboardType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.keyboard",         /* tp_name */
+    sizeof(Device),            /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)Device_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+        Py_TPFLAGS_BASETYPE,   /* tp_flags */
+    "the generic keyboard",    /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Keyboard_methods,          /* tp_methods */
+    0,                         /* tp_members */
+    0,                         /* tp_getset */
+    &DeviceType,               /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)Keyboard_init,   /* tp_init */
+    0,                         /* tp_alloc */
+    Keyboard_new,              /* tp_new */
+};
+
 static PyObject *
-DCPU_getZ(DCPU *self, void *closure)
+LEM1802_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-    PyObject *Z = PyLong_FromLong(self->cpu->Z);
-    if (Z == NULL) {
-        return NULL;
-    }
-
-    return Z;
+    return Device_wrap(type, new lem1802());
 }
 
 static int
-DCPU_setZ(DCPU *self, PyObject *value, void *closure)
+LEM1802_init(Device *self, PyObject *args, PyObject *kwds)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+    if (!PyArg_ParseTuple(args, ""))
         return -1;
-    }
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
+    if (Device_check_detached(self) < 0)
         return -1;
-    }
-
-    self->cpu->Z = PyLong_AsLong(value);
 
+    delete self->hw;
+    self->hw = new lem1802();
     return 0;
 }
 
 static PyObject *
-DCPU_getI(DCPU *self, void *closure)
+LEM1802_getscreen(Device *self, void *closure)
 {
-    PyObject *I = PyLong_FromLong(self->cpu->I);
-    if (I == NULL) {
-        return NULL;
-    }
-
-    return I;
+    return PyLong_FromLong(static_cast<lem1802 *>(self->hw)->screen);
 }
 
-static int
-DCPU_setI(DCPU *self, PyObject *value, void *closure)
+static PyObject *
+LEM1802_getfont(Device *self, void *closure)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
-        return -1;
-    }
-
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
-        return -1;
-    }
-
-    self->cpu->I = PyLong_AsLong(value);
-
-    return 0;
+    return PyLong_FromLong(static_cast<lem1802 *>(self->hw)->font);
 }
 
 static PyObject *
-DCPU_getJ(DCPU *self, void *closure)
+LEM1802_getpalette(Device *self, void *closure)
 {
-    PyObject *J = PyLong_FromLong(self->cpu->J);
-    if (J == NULL) {
-        return NULL;
-    }
-
-    return J;
+    return PyLong_FromLong(static_cast<lem1802 *>(self->hw)->palette);
 }
 
-static int
-DCPU_setJ(DCPU *self, PyObject *value, void *closure)
+static PyObject *
+LEM1802_getborder(Device *self, void *closure)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
-        return -1;
-    }
-
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
-        return -1;
-    }
-
-    self->cpu->J = PyLong_AsLong(value);
-
-    return 0;
+    return PyLong_FromLong(static_cast<lem1802 *>(self->hw)->border);
 }
 
 static PyObject *
-DCPU_getPC(DCPU *self, void *closure)
+LEM1802_getblink(Device *self, void *closure)
 {
-    PyObject *PC = PyLong_FromLong(self->cpu->PC);
-    if (PC == NULL) {
-        return NULL;
-    }
-
-    return PC;
+    return PyBool_FromLong(static_cast<lem1802 *>(self->hw)->blink);
 }
 
-static int
-DCPU_setPC(DCPU *self, PyObject *value, void *closure)
+static PyObject *
+LEM1802_render(Device *self, PyObject *args, PyObject *kwds)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
-        return -1;
-    }
-
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
-        return -1;
-    }
+    PyObject *target;
+    int border = 0, force = 0;
 
-    self->cpu->PC = PyLong_AsLong(value);
+    static char *kwlist[] = {
+        const_cast<char *>("buffer"), const_cast<char *>("border"),
+        const_cast<char *>("force"), NULL
+    };
 
-    return 0;
-}
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|ip", kwlist, &target, &border, &force))
+        return NULL;
 
-static PyObject *
-DCPU_getSP(DCPU *self, void *closure)
-{
-    PyObject *SP = PyLong_FromLong(self->cpu->SP);
-    if (SP == NULL) {
+    if (border < 0) {
+        PyErr_SetString(PyExc_ValueError, "The border cannot be negative");
         return NULL;
     }
 
-    return SP;
-}
+    // the screen is drawn from the cpu's RAM
+    if (Device_check_stopped(self) < 0)
+        return NULL;
 
-static int
-DCPU_setSP(DCPU *self, PyObject *value, void *closure)
-{
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
-        return -1;
-    }
+    Py_buffer view;
+    if (PyObject_GetBuffer(target, &view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0)
+        return NULL;
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
-        return -1;
+    // RGB or RGBA is told apart by the size of the buffer
+    Py_ssize_t pixels = (Py_ssize_t)(lem1802::WIDTH + 2 * border) * (lem1802::HEIGHT + 2 * border);
+    int channels = view.len == pixels * 3 ? 3 : view.len == pixels * 4 ? 4 : 0;
+
+    if (view.itemsize != 1 || channels == 0) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError,
+                     "The buffer must hold %dx%d RGB or RGBA bytes",
+                     lem1802::WIDTH + 2 * border, lem1802::HEIGHT + 2 * border);
+        return NULL;
     }
 
-    self->cpu->SP = PyLong_AsLong(value);
+    bool changed = static_cast<lem1802 *>(self->hw)->render(
+        (std::uint8_t *)view.buf, channels, border, force);
+    PyBuffer_Release(&view);
 
-    return 0;
+    return PyBool_FromLong(changed);
 }
 
-static PyObject *
-DCPU_getEX(DCPU *self, void *closure)
-{
+static PyMethodDef LEM1802_methods[] = {
+    {"render", (PyCFunction)LEM1802_render, METH_VARARGS | METH_KEYWORDS,
+     "Draw the screen into a writable RGB or RGBA buffer, framed by border "
+     "pixels of the border colour; returns False, leaving the buffer alone, "
+     "if nothing changed since the last frame unless force is set. Cannot "
+     "be called while the cpu runs, except from its python devices"
+    },
+    {NULL} /* Sentinel */
+};
+
+static PyGetSetDef LEM1802_getseters[] = {
+    {"screen",
+     (getter)LEM1802_getscreen, NULL,
+     "the address video RAM is mapped to, or 0 when disconnected",
+     NULL},
+    {"font",
+     (getter)LEM1802_getfont, NULL,
+     "the address font RAM is mapped to, or 0 for the default font",
+     NULL},
+    {"palette",
+     (getter)LEM1802_getpalette, NULL,
+     "the address palette RAM is mapped to, or 0 for the default palette",
+     NULL},
+    {"border",
+     (getter)LEM1802_getborder, NULL,
+     "the palette index of the border colour",
+     NULL},
+    {"blink",
+     (getter)LEM1802_getblink, NULL,
+     "whether blinking characters are currently shown",
+     NULL},
+    {NULL}  /* Sentinel */
+};
+
+static PyTypeObject LEM1802Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.lem1802",          /* tp_name */
+    sizeof(Device),            /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)Device_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+        Py_TPFLAGS_BASETYPE,   /* tp_flags */
+    "the LEM1802 low energy monitor", /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    LEM1802_methods,           /* tp_methods */
+    0,                         /* tp_members */
+    LEM1802_getseters,         /* tp_getset */
+    &DeviceType,               /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)LEM1802_init,    /* tp_init */
+    0,                         /* tp_alloc */
+    LEM1802_new,               /* tp_new */
+};
+
+static PyObject *
+M35FD_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    return Device_wrap(type, new m35fd());
+}
+
+static int
+M35FD_init(Device *self, PyObject *args, PyObject *kwds)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return -1;
+
+    if (Device_check_detached(self) < 0)
+        return -1;
+
+    delete self->hw;
+    self->hw = new m35fd();
+    return 0;
+}
+
+/// refuses images of more words than fit on a disk
+static int
+check_disk_size(Py_ssize_t count)
+{
+    if (count > (Py_ssize_t)(m35fd::SECTORS * m35fd::SECTOR_WORDS)) {
+        PyErr_SetString(PyExc_ValueError, "Disk images can hold at most 1440 sectors");
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *
+M35FD_insert(Device *self, PyObject *args, PyObject *kwds)
+{
+    PyObject *image = Py_None;
+    int write_protected = 0;
+    const char *byteorder = NULL;
+
+    static char *kwlist[] = {
+        const_cast<char *>("image"), const_cast<char *>("write_protected"),
+        const_cast<char *>("byteorder"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|Opz", kwlist,
+                                     &image, &write_protected, &byteorder))
+        return NULL;
+
+    bool swap = false;
+    if (image != Py_None && parse_byteorder(byteorder, image, swap) < 0)
+        return NULL;
+
+    if (image == Py_None && byteorder != NULL) {
+        PyErr_SetString(PyExc_TypeError, "A byteorder can only be given with an image");
+        return NULL;
+    }
+
+    if (Device_check_stopped(self) < 0)
+        return NULL;
+
+    m35fd *drive = static_cast<m35fd *>(self->hw);
+    std::vector<std::uint16_t> words;
+    word_layout layout = LAYOUT_SEQUENCE;
+
+    // images are read the way flash() reads them
+    if (image != Py_None && PyObject_CheckBuffer(image)) {
+        Py_buffer view;
+        const void *data;
+        std::vector<char> copy;
+        if (get_contiguous_buffer(image, &view, data, copy) < 0)
+            return NULL;
+
+        layout = byteorder != NULL ? LAYOUT_WORDS : layout_of(view, swap);
+
+        if (layout == LAYOUT_WORDS) {
+            if (view.len % 2 != 0) {
+                PyBuffer_Release(&view);
+                PyErr_SetString(PyExc_ValueError, "Raw images must hold a whole number of words");
+                return NULL;
+            }
+
+            if (check_disk_size(view.len / 2) < 0) {
+                PyBuffer_Release(&view);
+                return NULL;
+            }
+
+            const std::uint16_t *image_words = (const std::uint16_t *)data;
+            words.assign(image_words, image_words + view.len / 2);
+
+            if (swap) {
+                for (auto& word : words) {
+                    word = (word >> 8) | (word << 8);
+                }
+            }
+        } else if (layout == LAYOUT_BYTES) {
+            if (check_disk_size(view.len) < 0) {
+                PyBuffer_Release(&view);
+                return NULL;
+            }
+
+            const unsigned char *bytes = (const unsigned char *)data;
+            words.assign(bytes, bytes + view.len);
+        }
+
+        PyBuffer_Release(&view);
+    }
+
+    // anything else goes through array('H'), which checks every item
+    if (image != Py_None && layout == LAYOUT_SEQUENCE) {
+        PyObject *array = PyObject_CallFunction(ArrayType, "sO", "H", image);
+        if (array == NULL)
+            return NULL;
+
+        Py_buffer view;
+        int status = PyObject_GetBuffer(array, &view, PyBUF_C_CONTIGUOUS);
+        Py_DECREF(array);
+        if (status < 0)
+            return NULL;
+
+        if (check_disk_size(view.len / 2) < 0) {
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+
+        const std::uint16_t *image_words = (const std::uint16_t *)view.buf;
+        words.assign(image_words, image_words + view.len / 2);
+        PyBuffer_Release(&view);
+    }
+
+    try {
+        drive->insert(words.data(), words.size(), write_protected);
+    } catch (galaxy::saturn::queue_overflow& e) {
+        PyErr_SetString(QueueOverflowError, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+M35FD_eject(Device *self)
+{
+    if (Device_check_stopped(self) < 0)
+        return NULL;
+
+    try {
+        static_cast<m35fd *>(self->hw)->eject();
+    } catch (galaxy::saturn::queue_overflow& e) {
+        PyErr_SetString(QueueOverflowError, e.what());
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+M35FD_getstate(Device *self, void *closure)
+{
+    return PyLong_FromLong(static_cast<m35fd *>(self->hw)->state);
+}
+
+static PyObject *
+M35FD_geterror(Device *self, void *closure)
+{
+    return PyLong_FromLong(static_cast<m35fd *>(self->hw)->error);
+}
+
+static PyObject *
+M35FD_getdisk(Device *self, void *closure)
+{
+    // sector writes change the disk as the cpu runs
+    if (Device_check_stopped(self) < 0)
+        return NULL;
+
+    m35fd *drive = static_cast<m35fd *>(self->hw);
+    if (drive->disk.empty())
+        Py_RETURN_NONE;
+
+    return array_from_words(drive->disk.data(), drive->disk.size());
+}
+
+static PyMethodDef M35FD_methods[] = {
+    {"insert", (PyCFunction)M35FD_insert, METH_VARARGS | METH_KEYWORDS,
+     "Insert a disk, optionally holding an image read with the rules of "
+     "flash(), byteorder included; unwritten sectors are zeroed"
+    },
+    {"eject", (PyCFunction)M35FD_eject, METH_NOARGS,
+     "Eject the disk"
+    },
+    {NULL} /* Sentinel */
+};
+
+static PyGetSetDef M35FD_getseters[] = {
+    {"state",
+     (getter)M35FD_getstate, NULL,
+     "the state of the drive, as reported to the cpu",
+     NULL},
+    {"error",
+     (getter)M35FD_geterror, NULL,
+     "the last error, as reported to the cpu",
+     NULL},
+    {"disk",
+     (getter)M35FD_getdisk, NULL,
+     "a copy of the inserted disk as an array of words, or None",
+     NULL},
+    {NULL}  /* Sentinel */
+};
+
+static PyTypeObject M35FDType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.m35fd",            /* tp_name */
+    sizeof(Device),            /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)Device_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+        Py_TPFLAGS_BASETYPE,   /* tp_flags */
+    "the M35FD floppy drive",  /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    M35FD_methods,             /* tp_methods */
+    0,                         /* tp_members */
+    M35FD_getseters,           /* tp_getset */
+    &DeviceType,               /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)M35FD_init,      /* tp_init */
+    0,                         /* tp_alloc */
+    M35FD_new,                 /* tp_new */
+};
+
+struct State {
+    PyObject_HEAD
+
+    /// the saved registers and RAM
+    dcpu_state* state;
+};
+
+static void
+State_dealloc(State* self)
+{
+    delete self->state;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject *
+State_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    PyObject *data;
+
+    if (!PyArg_ParseTuple(args, "O", &data))
+        return NULL;
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(data, &view, PyBUF_C_CONTIGUOUS) < 0)
+        return NULL;
+
+    if (view.len != sizeof(dcpu_state)) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "State data must be %zd bytes long", (Py_ssize_t)sizeof(dcpu_state));
+        return NULL;
+    }
+
+    State *self = (State *)type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->state = new dcpu_state;
+        std::memcpy(self->state, view.buf, sizeof(dcpu_state));
+    }
+
+    PyBuffer_Release(&view);
+    return (PyObject *)self;
+}
+
+static PyObject *
+State_reduce(State *self)
+{
+    PyObject *data = PyBytes_FromStringAndSize((const char *)self->state, sizeof(dcpu_state));
+    if (data == NULL)
+        return NULL;
+
+    return Py_BuildValue("O(N)", Py_TYPE(self), data);
+}
+
+static PyMethodDef State_methods[] = {
+    {"__reduce__", (PyCFunction)State_reduce, METH_NOARGS,
+     "Pickle the state as its raw words"
+    },
+    {NULL} /* Sentinel */
+};
+
+static Py_ssize_t State_shape[] = {REGISTER_COUNT + RAM_WORDS};
+static Py_ssize_t State_strides[] = {sizeof(std::uint16_t)};
+
+static int
+State_getbuffer(State *self, Py_buffer *view, int flags)
+{
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "States are immutable");
+        view->obj = NULL;
+        return -1;
+    }
+
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+
+    view->buf = self->state;
+    view->len = sizeof(dcpu_state);
+    view->readonly = 1;
+    view->itemsize = sizeof(std::uint16_t);
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>("H") : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? State_shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? State_strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    return 0;
+}
+
+static PyBufferProcs State_as_buffer = {
+    (getbufferproc)State_getbuffer,             /* bf_getbuffer */
+    0,                                          /* bf_releasebuffer */
+};
+
+static PyTypeObject StateType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "galaxpy.saturn.state",    /* tp_name, in full so pickle can find it */
+    sizeof(State),             /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)State_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    &State_as_buffer,          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "a saved copy of a dcpu's registers (A B C X Y Z I J PC SP EX IA) "
+    "followed by its RAM",     /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    State_methods,             /* tp_methods */
+    0,                         /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    0,                         /* tp_init */
+    0,                         /* tp_alloc */
+    State_new,                 /* tp_new */
+};
+
+struct Trace {
+    PyObject_HEAD
+
+    /// the drained entries, oldest first
+    std::vector<trace_entry>* entries;
+
+    /// the number of entries lost to the ring buffer wrapping before the drain
+    unsigned long long dropped;
+
+    Py_ssize_t shape[1];
+    Py_ssize_t strides[1];
+};
+
+/// trace_entry as a PEP 3118 struct, which numpy reads as a record dtype
+static const char *Trace_format =
+    "T{Q:cycle:H:pc:(3)H:words:H:a:H:b:H:length:2x:}";
+
+static_assert(sizeof(trace_entry) == 24, "Trace_format does not match trace_entry");
+
+static void
+Trace_dealloc(Trace* self)
+{
+    delete self->entries;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static Py_ssize_t
+Trace_length(Trace *self)
+{
+    return self->entries->size();
+}
+
+static PyObject *
+Trace_item(Trace *self, Py_ssize_t i)
+{
+    if (i < 0 || i >= (Py_ssize_t)self->entries->size()) {
+        PyErr_SetString(PyExc_IndexError, "trace index out of range");
+        return NULL;
+    }
+
+    const trace_entry& entry = (*self->entries)[i];
+
+    PyObject *words = PyTuple_New(entry.length);
+    if (words == NULL)
+        return NULL;
+
+    for (int w = 0; w < entry.length; w++) {
+        PyTuple_SET_ITEM(words, w, PyLong_FromLong(entry.words[w]));
+    }
+
+    return Py_BuildValue("(KHNHH)", (unsigned long long)entry.cycle, entry.pc,
+                         words, entry.a, entry.b);
+}
+
+static PySequenceMethods Trace_as_sequence = {
+    (lenfunc)Trace_length,                      /* sq_length */
+    0,                                          /* sq_concat */
+    0,                                          /* sq_repeat */
+    (ssizeargfunc)Trace_item,                   /* sq_item */
+    0,                                          /* sq_slice */
+    0,                                          /* sq_ass_item */
+    0,                                          /* sq_ass_slice */
+    0,                                          /* sq_contains */
+    0,                                          /* sq_inplace_concat */
+    0,                                          /* sq_inplace_repeat */
+};
+
+static int
+Trace_getbuffer(Trace *self, Py_buffer *view, int flags)
+{
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Traces are immutable");
+        view->obj = NULL;
+        return -1;
+    }
+
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+
+    view->buf = self->entries->data();
+    view->len = self->entries->size() * sizeof(trace_entry);
+    view->readonly = 1;
+    view->itemsize = sizeof(trace_entry);
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>(Trace_format) : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    return 0;
+}
+
+static PyBufferProcs Trace_as_buffer = {
+    (getbufferproc)Trace_getbuffer,             /* bf_getbuffer */
+    0,                                          /* bf_releasebuffer */
+};
+
+static PyMemberDef Trace_members[] = {
+    {const_cast<char *>("dropped"), T_ULONGLONG, offsetof(Trace, dropped), READONLY,
+     const_cast<char *>("how many older entries were overwritten before this drain")},
+    {NULL}  /* Sentinel */
+};
+
+static PyTypeObject TraceType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.trace",            /* tp_name */
+    sizeof(Trace),             /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)Trace_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    &Trace_as_sequence,        /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    &Trace_as_buffer,          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "instructions drained from a dcpu's trace, indexable as "
+    "(cycle, pc, words, a, b) tuples or readable as a record buffer, "
+    "e.g. with numpy.frombuffer", /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    0,                         /* tp_methods */
+    Trace_members,             /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    0,                         /* tp_init */
+    0,                         /* tp_alloc */
+    0,                         /* tp_new */
+};
+
+/**
+ * exports one of a profile's counter arrays as a read-only buffer, keeping
+ * the profile alive for as long as a memoryview of it is
+ */
+struct Counters {
+    PyObject_HEAD
+
+    /// the profile the counters belong to
+    PyObject *owner;
+
+    const std::uint64_t *counts;
+
+    Py_ssize_t shape[1];
+};
+
+static Py_ssize_t Counters_strides[] = {sizeof(std::uint64_t)};
+
+static void
+Counters_dealloc(Counters* self)
+{
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int
+Counters_getbuffer(Counters *self, Py_buffer *view, int flags)
+{
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Profile counters are read-only");
+        view->obj = NULL;
+        return -1;
+    }
+
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+
+    view->buf = const_cast<std::uint64_t *>(self->counts);
+    view->len = self->shape[0] * sizeof(std::uint64_t);
+    view->readonly = 1;
+    view->itemsize = sizeof(std::uint64_t);
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>("Q") : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? Counters_strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    return 0;
+}
+
+static PyBufferProcs Counters_as_buffer = {
+    (getbufferproc)Counters_getbuffer,          /* bf_getbuffer */
+    0,                                          /* bf_releasebuffer */
+};
+
+static PyTypeObject CountersType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.counters",         /* tp_name */
+    sizeof(Counters),          /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)Counters_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    &Counters_as_buffer,       /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "the buffer behind a profile's counter memoryviews", /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    0,                         /* tp_methods */
+    0,                         /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    0,                         /* tp_init */
+    0,                         /* tp_alloc */
+    0,                         /* tp_new */
+};
+
+/// a read-only memoryview of 'Q' over `count` live counters owned by `owner`
+static PyObject *
+memoryview_of_counts(PyObject *owner, const std::uint64_t *counts, Py_ssize_t count)
+{
+    Counters *counters = PyObject_New(Counters, &CountersType);
+    if (counters == NULL)
+        return NULL;
+
+    Py_INCREF(owner);
+    counters->owner = owner;
+    counters->counts = counts;
+    counters->shape[0] = count;
+
+    PyObject *view = PyMemoryView_FromObject((PyObject *)counters);
+    Py_DECREF(counters);
+    return view;
+}
+
+struct Profile {
+    PyObject_HEAD
+
+    profiler* counters;
+
+    /// set while a dcpu is updating the counters
+    bool attached;
+};
+
+static void
+Profile_dealloc(Profile* self)
+{
+    delete self->counters;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject *
+Profile_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+
+    Profile *self = (Profile *)type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->counters = new profiler;
+        self->attached = false;
+    }
+
+    return (PyObject *)self;
+}
+
+static PyObject *
+Profile_reset(Profile *self)
+{
+    self->counters->reset();
+    Py_RETURN_NONE;
+}
+
+/**
+ * the labels to fold by, either from an asteroid's exported_labels or
+ * from a plain mapping of names to addresses, sorted by address
+ */
+static int
+labels_by_address(PyObject *labels, std::vector<std::pair<long, PyObject *> >& out)
+{
+    PyObject *mapping;
+    if (PyObject_HasAttrString(labels, "exported_labels")) {
+        mapping = PyObject_GetAttrString(labels, "exported_labels");
+    } else {
+        Py_INCREF(labels);
+        mapping = labels;
+    }
+
+    if (mapping == NULL)
+        return -1;
+
+    PyObject *items = PyMapping_Items(mapping);
+    Py_DECREF(mapping);
+    if (items == NULL)
+        return -1;
+
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(items); i++) {
+        PyObject *name, *address;
+        if (!PyArg_ParseTuple(PyList_GET_ITEM(items, i), "OO", &name, &address)) {
+            Py_DECREF(items);
+            return -1;
+        }
+
+        long value = PyLong_AsLong(address);
+        if (value == -1 && PyErr_Occurred()) {
+            Py_DECREF(items);
+            return -1;
+        }
+
+        out.push_back(std::make_pair(value, name));
+    }
+
+    // the names are borrowed from items, which is kept alive by the caller
+    std::stable_sort(out.begin(), out.end(),
+        [](const std::pair<long, PyObject *>& x, const std::pair<long, PyObject *>& y) {
+            return x.first < y.first;
+        });
+
+    Py_DECREF(items);
+    return 0;
+}
+
+static PyObject *
+Profile_fold(Profile *self, PyObject *args)
+{
+    PyObject *labels;
+
+    if (!PyArg_ParseTuple(args, "O", &labels))
+        return NULL;
+
+    std::vector<std::pair<long, PyObject *> > sorted;
+    if (labels_by_address(labels, sorted) < 0)
+        return NULL;
+
+    PyObject *totals = PyDict_New();
+    if (totals == NULL)
+        return NULL;
+
+    // every address counts towards the closest label at or before it
+    for (std::size_t i = 0; i < sorted.size(); i++) {
+        long begin = std::max(sorted[i].first, 0L);
+        long end = i + 1 < sorted.size() ? sorted[i + 1].first : PC_SLOTS;
+
+        unsigned long long total = 0;
+        for (long pc = begin; pc < std::min(end, (long)PC_SLOTS); pc++) {
+            total += self->counters->pc_counts[pc];
+        }
+
+        PyObject *value = PyLong_FromUnsignedLongLong(total);
+        if (value == NULL || PyDict_SetItem(totals, sorted[i].second, value) < 0) {
+            Py_XDECREF(value);
+            Py_DECREF(totals);
+            return NULL;
+        }
+
+        Py_DECREF(value);
+    }
+
+    return totals;
+}
+
+static PyMethodDef Profile_methods[] = {
+    {"reset", (PyCFunction)Profile_reset, METH_NOARGS,
+     "Zero every counter"
+    },
+    {"fold", (PyCFunction)Profile_fold, METH_VARARGS,
+     "Total the PC histogram per label, given an asteroid or a mapping of "
+     "label names to addresses; each address counts towards the closest "
+     "label at or before it"
+    },
+    {NULL} /* Sentinel */
+};
+
+static PyObject *
+Profile_getopcode_counts(Profile *self, void *closure)
+{
+    return memoryview_of_counts((PyObject *)self, self->counters->opcode_counts, OPCODE_SLOTS);
+}
+
+static PyObject *
+Profile_getopcode_cycles(Profile *self, void *closure)
+{
+    return memoryview_of_counts((PyObject *)self, self->counters->opcode_cycles, OPCODE_SLOTS);
+}
+
+static PyObject *
+Profile_getpc_counts(Profile *self, void *closure)
+{
+    return memoryview_of_counts((PyObject *)self, self->counters->pc_counts, PC_SLOTS);
+}
+
+static PyObject *
+Profile_getinterrupts(Profile *self, void *closure)
+{
+    return PyLong_FromUnsignedLongLong(self->counters->interrupts);
+}
+
+static PyGetSetDef Profile_getseters[] = {
+    {"opcode_counts",
+     (getter)Profile_getopcode_counts, NULL,
+     "a live, read-only memoryview of 'Q' counting how often each opcode "
+     "ran, basic opcodes at their own value and special opcodes at 0x20 "
+     "plus theirs",
+     NULL},
+    {"opcode_cycles",
+     (getter)Profile_getopcode_cycles, NULL,
+     "a live, read-only memoryview of 'Q' of the cycles spent in each "
+     "opcode, laid out like opcode_counts",
+     NULL},
+    {"pc_counts",
+     (getter)Profile_getpc_counts, NULL,
+     "a live, read-only memoryview of 'Q' counting how many instructions "
+     "ran from each address",
+     NULL},
+    {"interrupts",
+     (getter)Profile_getinterrupts, NULL,
+     "roughly how many times the cpu entered its interrupt handler; "
+     "dispatches are inferred from the stack, so a few can be missed or "
+     "counted when none happened",
+     NULL},
+    {NULL}  /* Sentinel */
+};
+
+static PyTypeObject ProfileType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.profile",          /* tp_name */
+    sizeof(Profile),           /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)Profile_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "per-opcode, per-address and interrupt counters, filled in while "
+    "attached to a dcpu's profile attribute", /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Profile_methods,           /* tp_methods */
+    0,                         /* tp_members */
+    Profile_getseters,         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    0,                         /* tp_init */
+    0,                         /* tp_alloc */
+    Profile_new,               /* tp_new */
+};
+
+struct DCPU {
+    PyObject_HEAD
+
+    /// the cpu the object is wrapping
+    galaxy::saturn::dcpu* cpu;
+
+    /// the attached devices, kept alive for as long as the cpu can call them
+    PyObject *devices;
+
+    /// how many of the attached devices had python callbacks when last bound
+    Py_ssize_t python_devices;
+
+    /// set while the cpu is being run without the GIL
+    bool running;
+
+    /// the instruction trace, or NULL when tracing is off
+    trace_buffer* trace;
+
+    /// the attached profile object, or NULL when profiling is off
+    Profile *profile;
+
+    /// the watched addresses, or NULL if nothing has ever been watched
+    watch_set* watches;
+
+    /// the copy of RAM take_dirty_ranges compares against
+    dirty_tracker* dirty;
+
+    /// interrupts raised while the cpu is running on another thread
+    interrupt_queue* pending;
+};
+
+static void
+DCPU_dealloc(DCPU* self)
+{
+    PyObject_GC_UnTrack(self);
+
+    // attached devices can outlive the cpu, and must stop using it
+    for (Py_ssize_t i = 0; self->devices != NULL && i < PyList_GET_SIZE(self->devices); i++) {
+        Device_detach((Device *)PyList_GET_ITEM(self->devices, i));
+    }
+
+    delete self->cpu;
+    delete self->trace;
+    delete self->watches;
+    delete self->dirty;
+    delete self->pending;
+    if (self->profile != NULL) {
+        self->profile->attached = false;
+        Py_DECREF(self->profile);
+    }
+    Py_XDECREF(self->devices);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+/// devices that refer back to their cpu make cycles through its devices list
+static int
+DCPU_traverse(DCPU *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->devices);
+    Py_VISIT(self->profile);
+    return 0;
+}
+
+static PyObject *
+DCPU_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    DCPU *self;
+
+    self = (DCPU *)type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->devices = PyList_New(0);
+        if (self->devices == NULL) {
+            Py_DECREF(self);
+            return NULL;
+        }
+
+        self->cpu = new galaxy::saturn::dcpu();
+        self->python_devices = 0;
+        self->running = false;
+        self->trace = NULL;
+        self->profile = NULL;
+        self->watches = NULL;
+        self->dirty = NULL;
+        self->pending = new interrupt_queue;
+    }
+
+    return (PyObject *)self;
+}
+
+static int
+DCPU_init(DCPU *self, PyObject *args, PyObject *kwds)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return -1;
+
+    return 0;
+}
+
+static int
+DCPU_check_running(DCPU* self)
+{
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "The DCPU is already running");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * refuses to change the cpu's registers or RAM while it runs, unless the
+ * run is stopped inside one of its python devices on this thread
+ */
+static int
+DCPU_check_stopped(DCPU* self)
+{
+    if (self->running && !PyDevice::calling(self->cpu)) {
+        PyErr_SetString(PyExc_RuntimeError, "The DCPU is running");
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getA(DCPU *self, void *closure)
+{
+    PyObject *A = PyLong_FromLong(self->cpu->A);
+    if (A == NULL) {
+        return NULL;
+    }
+
+    return A;
+}
+
+static int
+DCPU_setA(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->A = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getB(DCPU *self, void *closure)
+{
+    PyObject *B = PyLong_FromLong(self->cpu->B);
+    if (B == NULL) {
+        return NULL;
+    }
+
+    return B;
+}
+
+static int
+DCPU_setB(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->B = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getC(DCPU *self, void *closure)
+{
+    PyObject *C = PyLong_FromLong(self->cpu->C);
+    if (C == NULL) {
+        return NULL;
+    }
+
+    return C;
+}
+
+static int
+DCPU_setC(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->C = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getX(DCPU *self, void *closure)
+{
+    PyObject *X = PyLong_FromLong(self->cpu->X);
+    if (X == NULL) {
+        return NULL;
+    }
+
+    return X;
+}
+
+static int
+DCPU_setX(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->X = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getY(DCPU *self, void *closure)
+{
+    PyObject *Y = PyLong_FromLong(self->cpu->Y);
+    if (Y == NULL) {
+        return NULL;
+    }
+
+    return Y;
+}
+
+static int
+DCPU_setY(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->Y = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getZ(DCPU *self, void *closure)
+{
+    PyObject *Z = PyLong_FromLong(self->cpu->Z);
+    if (Z == NULL) {
+        return NULL;
+    }
+
+    return Z;
+}
+
+static int
+DCPU_setZ(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->Z = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getI(DCPU *self, void *closure)
+{
+    PyObject *I = PyLong_FromLong(self->cpu->I);
+    if (I == NULL) {
+        return NULL;
+    }
+
+    return I;
+}
+
+static int
+DCPU_setI(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->I = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getJ(DCPU *self, void *closure)
+{
+    PyObject *J = PyLong_FromLong(self->cpu->J);
+    if (J == NULL) {
+        return NULL;
+    }
+
+    return J;
+}
+
+static int
+DCPU_setJ(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->J = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getPC(DCPU *self, void *closure)
+{
+    PyObject *PC = PyLong_FromLong(self->cpu->PC);
+    if (PC == NULL) {
+        return NULL;
+    }
+
+    return PC;
+}
+
+static int
+DCPU_setPC(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->PC = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getSP(DCPU *self, void *closure)
+{
+    PyObject *SP = PyLong_FromLong(self->cpu->SP);
+    if (SP == NULL) {
+        return NULL;
+    }
+
+    return SP;
+}
+
+static int
+DCPU_setSP(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->SP = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getEX(DCPU *self, void *closure)
+{
     PyObject *EX = PyLong_FromLong(self->cpu->EX);
     if (EX == NULL) {
         return NULL;
     }
 
-    return EX;
+    return EX;
+}
+
+static int
+DCPU_setEX(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->EX = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getIA(DCPU *self, void *closure)
+{
+    PyObject *IA = PyLong_FromLong(self->cpu->IA);
+    if (IA == NULL) {
+        return NULL;
+    }
+
+    return IA;
+}
+
+static int
+DCPU_setIA(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+        return -1;
+    }
+
+    if (! PyLong_Check(value)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "The first attribute value must be an integer");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    self->cpu->IA = PyLong_AsLong(value);
+
+    return 0;
+}
+
+static PyObject *
+DCPU_get_registers(DCPU *self)
+{
+    std::uint16_t registers[REGISTER_COUNT];
+    save_registers(*self->cpu, registers);
+
+    return array_from_words(registers, REGISTER_COUNT);
+}
+
+static int
+DCPU_setregisters(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Cannot delete the registers attribute");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    std::uint16_t registers[REGISTER_COUNT];
+    if (words_from_object(value, registers, REGISTER_COUNT) < 0)
+        return -1;
+
+    load_registers(*self->cpu, registers);
+    return 0;
+}
+
+static PyObject *
+DCPU_set_registers(DCPU *self, PyObject *args)
+{
+    PyObject *value;
+
+    if (!PyArg_ParseTuple(args, "O", &value))
+        return NULL;
+
+    if (DCPU_setregisters(self, value, NULL) < 0)
+        return NULL;
+
+    Py_RETURN_NONE;
+}
+
+/// forgets interrupts that were raised while the cpu was running
+static void
+DCPU_drop_pending(DCPU* self)
+{
+    std::uint16_t message;
+    while (self->pending->pop(message)) {
+    }
+}
+
+/// hands interrupts left over from a background run to the cpu
+static int
+DCPU_deliver_pending(DCPU* self)
+{
+    std::uint16_t message;
+
+    try {
+        while (self->pending->pop(message)) {
+            self->cpu->interrupt(message);
+        }
+    } catch (galaxy::saturn::queue_overflow& e) {
+        PyErr_SetString(QueueOverflowError, e.what());
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *
+DCPU_getprofile(DCPU *self, void *closure)
+{
+    PyObject *profile = self->profile != NULL ? (PyObject *)self->profile : Py_None;
+    Py_INCREF(profile);
+    return profile;
+}
+
+static int
+DCPU_setprofile(DCPU *self, PyObject *value, void *closure)
+{
+    if (value == NULL || (value != Py_None && !PyObject_TypeCheck(value, &ProfileType))) {
+        PyErr_SetString(PyExc_TypeError, "The profile must be a profile object or None");
+        return -1;
+    }
+
+    if (DCPU_check_running(self) < 0)
+        return -1;
+
+    if (value == (PyObject *)self->profile)
+        return 0;
+
+    Profile *profile = value != Py_None ? (Profile *)value : NULL;
+    if (profile != NULL && profile->attached) {
+        PyErr_SetString(PyExc_ValueError, "The profile is already attached to a dcpu");
+        return -1;
+    }
+
+    if (self->profile != NULL) {
+        self->profile->attached = false;
+        Py_DECREF(self->profile);
+    }
+
+    if (profile != NULL) {
+        profile->attached = true;
+        Py_INCREF(profile);
+    }
+
+    self->profile = profile;
+    return 0;
+}
+
+static PyGetSetDef DCPU_getseters[] = {
+    {"A",
+     (getter)DCPU_getA, (setter)DCPU_setA,
+     "register A",
+     NULL},
+    {"B",
+     (getter)DCPU_getB, (setter)DCPU_setB,
+     "register B",
+     NULL},
+    {"C",
+     (getter)DCPU_getC, (setter)DCPU_setC,
+     "register C",
+     NULL},
+    {"X",
+     (getter)DCPU_getX, (setter)DCPU_setX,
+     "register X",
+     NULL},
+    {"Y",
+     (getter)DCPU_getY, (setter)DCPU_setY,
+     "register Y",
+     NULL},
+    {"Z",
+     (getter)DCPU_getZ, (setter)DCPU_setZ,
+     "register Z",
+     NULL},
+    {"I",
+     (getter)DCPU_getI, (setter)DCPU_setI,
+     "register I",
+     NULL},
+    {"J",
+     (getter)DCPU_getJ, (setter)DCPU_setJ,
+     "register J",
+     NULL},
+    {"PC",
+     (getter)DCPU_getPC, (setter)DCPU_setPC,
+     "register PC",
+     NULL},
+    {"SP",
+     (getter)DCPU_getSP, (setter)DCPU_setSP,
+     "register SP",
+     NULL},
+    {"EX",
+     (getter)DCPU_getEX, (setter)DCPU_setEX,
+     "register EX",
+     NULL},
+    {"IA",
+     (getter)DCPU_getIA, (setter)DCPU_setIA,
+     "register IA",
+     NULL},
+    {"profile",
+     (getter)DCPU_getprofile, (setter)DCPU_setprofile,
+     "the profile object counting what the cpu executes, or None",
+     NULL},
+    {"registers",
+     (getter)DCPU_get_registers, (setter)DCPU_setregisters,
+     "all twelve registers as an array('H'), in the order "
+     "A B C X Y Z I J PC SP EX IA",
+     NULL},
+    {NULL}  /* Sentinel */
+};
+
+/**
+ * binds the callbacks of the cpu's python devices again before a run, so
+ * that callbacks assigned since the last one are used, and counts the
+ * devices that have any
+ */
+static int
+DCPU_bind_devices(DCPU* self)
+{
+    Py_ssize_t python_devices = 0;
+
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(self->devices); i++) {
+        Device *dev = (Device *)PyList_GET_ITEM(self->devices, i);
+        PyDevice *pydev = dynamic_cast<PyDevice *>(dev->hw);
+        if (pydev == NULL)
+            continue;
+
+        if (Device_bind(pydev) < 0)
+            return -1;
+
+        if (!pydev->native())
+            python_devices++;
+    }
+
+    self->python_devices = python_devices;
+    return 0;
+}
+
+static PyObject *
+DCPU_cycle(DCPU* self)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    if (DCPU_deliver_pending(self) < 0)
+        return NULL;
+
+    if (DCPU_bind_devices(self) < 0)
+        return NULL;
+
+    cycle_start start = start_cycle(*self->cpu);
+    instruction ins = decode(self->cpu->ram[start.pc]);
+
+    if (self->trace != NULL)
+        self->trace->record(*self->cpu, ins);
+
+    // python devices are called from inside, and must not start another run
+    self->running = true;
+    try {
+        self->cpu->cycle();
+    } catch (galaxy::saturn::invalid_opcode& e) {
+        self->running = false;
+        PyErr_SetString(InvalidOpcodeError, e.what());
+        return NULL;
+    } catch (galaxy::saturn::queue_overflow& e) {
+        self->running = false;
+        PyErr_SetString(QueueOverflowError, e.what());
+        return NULL;
+    } catch (device_error& e) {
+        self->running = false;
+        return NULL;
+    }
+    self->running = false;
+
+    if (self->profile != NULL)
+        self->profile->counters->record(*self->cpu, start, ins);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+run_result_to_python(const run_result& result)
+{
+    PyObject *ret = PyStructSequence_New(&RunResultType);
+    if (ret == NULL)
+        return NULL;
+
+    PyStructSequence_SET_ITEM(ret, 0, PyLong_FromUnsignedLongLong(result.cycles));
+    PyStructSequence_SET_ITEM(ret, 1, PyLong_FromLong(result.reason));
+    PyStructSequence_SET_ITEM(ret, 2, PyLong_FromLong(result.pc));
+
+    if (result.reason == STOP_WATCHPOINT) {
+        PyStructSequence_SET_ITEM(ret, 3, PyLong_FromLong(result.watch.address));
+        PyStructSequence_SET_ITEM(ret, 4, PyLong_FromLong(result.watch.old_value));
+        PyStructSequence_SET_ITEM(ret, 5, PyLong_FromLong(result.watch.new_value));
+        PyStructSequence_SET_ITEM(ret, 6, PyLong_FromLong(result.watch.pc));
+    } else {
+        for (int i = 3; i <= 6; i++) {
+            Py_INCREF(Py_None);
+            PyStructSequence_SET_ITEM(ret, i, Py_None);
+        }
+    }
+
+    PyStructSequence_SET_ITEM(ret, 7, PyLong_FromUnsignedLongLong(result.skipped));
+    PyStructSequence_SET_ITEM(ret, 8, PyLong_FromUnsignedLongLong(result.gil_acquisitions));
+    if (PyErr_Occurred()) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
+/**
+ * adds the cpu's own trace, profile and watchpoints to `options`, along
+ * with its devices in `devices` if idle loops are to be skipped
+ */
+static int
+DCPU_add_options(DCPU* self, run_options& options, bool skip_idle,
+                 std::vector<native_device*>& devices)
+{
+    if (DCPU_bind_devices(self) < 0)
+        return -1;
+
+    if (skip_idle) {
+        if (self->python_devices != 0) {
+            PyErr_SetString(PyExc_ValueError, "Idle loops can only be skipped with purely native devices");
+            return -1;
+        }
+
+        // python devices without callbacks do nothing, so are always quiet
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(self->devices); i++) {
+            Device *dev = (Device *)PyList_GET_ITEM(self->devices, i);
+            native_device *native = dynamic_cast<native_device *>(dev->hw);
+            if (native != NULL)
+                devices.push_back(native);
+        }
+
+        options.skip_idle = &devices;
+    }
+
+    options.trace = self->trace;
+    options.interrupts = self->pending;
+    options.profile = self->profile != NULL ? self->profile->counters : NULL;
+    if (self->watches != NULL && !self->watches->empty())
+        options.watches = self->watches;
+
+    return 0;
+}
+
+/**
+ * runs the cpu without the GIL, which python devices take back only while
+ * their callbacks run; the cpu stays marked as running throughout, so that
+ * nothing can start another run of it from inside a device or at a GIL switch
+ */
+static run_result
+DCPU_run_native(DCPU* self, const run_options& options)
+{
+    run_result result;
+
+    self->running = true;
+    {
+        gil_release gil;
+        result = run(*self->cpu, options);
+        result.gil_acquisitions = gil.acquisitions;
+    }
+    self->running = false;
+
+    return result;
+}
+
+/**
+ * runs the cpu with the given options plus its own trace, profile and
+ * watchpoints, fast-forwarding idle loops if `skip_idle` is set
+ */
+static PyObject *
+DCPU_run_with(DCPU* self, run_options options, bool skip_idle)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    std::vector<native_device*> devices;
+    if (DCPU_add_options(self, options, skip_idle, devices) < 0)
+        return NULL;
+
+    run_result result = DCPU_run_native(self, options);
+    if (result.reason == STOP_DEVICE_ERROR)
+        return NULL;
+
+    return run_result_to_python(result);
+}
+
+/// runs python's signal handlers, taking the GIL back from the run to do so
+static bool
+signal_raised()
+{
+    gil_hold gil;
+    return PyErr_CheckSignals() < 0;
+}
+
+/**
+ * runs the cpu in slices paced by `pacer`, sleeping between them; the
+ * GIL must already have been let go of through a gil_release, and is
+ * taken back between slices so that signals such as Ctrl-C get through
+ */
+static run_result
+run_paced(DCPU* self, const run_options& options, realtime_pacer& pacer)
+{
+    run_result result = {0, STOP_BUDGET, self->cpu->PC, {0, 0, 0, 0}, 0, 0};
+
+    while (!pacer.done()) {
+        if (signal_raised()) {
+            result.reason = STOP_CANCELLED;
+            break;
+        }
+
+        std::uint64_t due = pacer.due();
+        if (due == 0) {
+            std::this_thread::sleep_until(pacer.next_slice());
+            continue;
+        }
+
+        run_options slice = options;
+        slice.cycles = due;
+
+        run_result ran = run(*self->cpu, slice);
+        pacer.ran(ran.cycles);
+
+        result.cycles += ran.cycles;
+        result.skipped += ran.skipped;
+        result.reason = ran.reason;
+        result.pc = ran.pc;
+        result.watch = ran.watch;
+        if (ran.reason != STOP_BUDGET)
+            break;
+    }
+
+    return result;
+}
+
+static PyObject *
+DCPU_run_realtime(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    unsigned int hz;
+    double duration;
+    int skip_idle = 0;
+
+    static char *kwlist[] = {
+        const_cast<char *>("hz"), const_cast<char *>("duration"),
+        const_cast<char *>("skip_idle"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Id|p", kwlist, &hz, &duration, &skip_idle))
+        return NULL;
+
+    if (hz == 0 || !(duration >= 0) || !std::isfinite(duration)) {
+        PyErr_SetString(PyExc_ValueError, "hz must be positive and duration finite and non-negative");
+        return NULL;
+    }
+
+    // the total number of cycles has to fit in 64 bits
+    if (duration * hz >= 18446744073709551616.0) {
+        PyErr_SetString(PyExc_OverflowError, "duration is too long to run at this rate");
+        return NULL;
+    }
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    run_options options = run_for(UINT64_MAX);
+    std::vector<native_device*> devices;
+    if (DCPU_add_options(self, options, skip_idle != 0, devices) < 0)
+        return NULL;
+
+    realtime_pacer pacer(hz, duration);
+    run_result result;
+
+    self->running = true;
+    {
+        gil_release gil;
+        result = run_paced(self, options, pacer);
+        result.gil_acquisitions = gil.acquisitions;
+    }
+    self->running = false;
+
+    // a device or signal handler raised an exception
+    if (result.reason == STOP_DEVICE_ERROR || PyErr_Occurred())
+        return NULL;
+
+    PyObject *run = run_result_to_python(result);
+    if (run == NULL)
+        return NULL;
+
+    PyObject *ret = PyStructSequence_New(&RealtimeResultType);
+    if (ret == NULL) {
+        Py_DECREF(run);
+        return NULL;
+    }
+
+    PyStructSequence_SET_ITEM(ret, 0, run);
+    PyStructSequence_SET_ITEM(ret, 1, PyFloat_FromDouble(pacer.elapsed()));
+    PyStructSequence_SET_ITEM(ret, 2, PyLong_FromUnsignedLongLong(pacer.stats.slices));
+    PyStructSequence_SET_ITEM(ret, 3, PyLong_FromUnsignedLongLong(pacer.stats.catch_ups));
+    PyStructSequence_SET_ITEM(ret, 4, PyLong_FromUnsignedLongLong(pacer.stats.dropped));
+    PyStructSequence_SET_ITEM(ret, 5, PyFloat_FromDouble(pacer.stats.max_lag));
+    if (PyErr_Occurred()) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
+static PyObject *
+DCPU_run(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    unsigned long long cycles;
+    int skip_idle = 0;
+
+    static char *kwlist[] = {
+        const_cast<char *>("cycles"), const_cast<char *>("skip_idle"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "K|p", kwlist, &cycles, &skip_idle))
+        return NULL;
+
+    run_options options = run_for(cycles);
+    return DCPU_run_with(self, options, skip_idle != 0);
+}
+
+static int
+breakpoints_from_iterable(PyObject *iterable, breakpoint_set& breakpoints)
+{
+    PyObject *iter = PyObject_GetIter(iterable);
+    if (iter == NULL)
+        return -1;
+
+    PyObject *item;
+    while ((item = PyIter_Next(iter)) != NULL) {
+        long address = PyLong_AsLong(item);
+        Py_DECREF(item);
+
+        if (address == -1 && PyErr_Occurred()) {
+            Py_DECREF(iter);
+            return -1;
+        }
+
+        if (address < 0 || address >= (long)breakpoints.size()) {
+            Py_DECREF(iter);
+            PyErr_SetString(PyExc_ValueError, "Breakpoint address out of range");
+            return -1;
+        }
+
+        breakpoints.set(address);
+    }
+
+    Py_DECREF(iter);
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+/// parses the arguments of run_until and run_until_async
+static int
+parse_run_until(PyObject *args, PyObject *kwds, run_options& options,
+                breakpoint_set& set, int& skip_idle)
+{
+    PyObject *breakpoints = NULL, *cycles = Py_None;
+    int stop_on_idle = 0;
+
+    static char *kwlist[] = {
+        const_cast<char *>("breakpoints"), const_cast<char *>("cycles"),
+        const_cast<char *>("stop_on_idle"), const_cast<char *>("skip_idle"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OOpp", kwlist,
+                                     &breakpoints, &cycles, &stop_on_idle, &skip_idle))
+        return -1;
+
+    options.cycles = UINT64_MAX;
+    options.stop_on_idle = stop_on_idle != 0;
+
+    if (cycles != Py_None) {
+        options.cycles = PyLong_AsUnsignedLongLong(cycles);
+        if (PyErr_Occurred())
+            return -1;
+    }
+
+    if (breakpoints != NULL && breakpoints != Py_None) {
+        if (breakpoints_from_iterable(breakpoints, set) < 0)
+            return -1;
+
+        options.breakpoints = &set;
+    }
+
+    return 0;
+}
+
+static PyObject *
+DCPU_run_until(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    run_options options = run_for(UINT64_MAX);
+    breakpoint_set set;
+    int skip_idle = 0;
+
+    if (parse_run_until(args, kwds, options, set, skip_idle) < 0)
+        return NULL;
+
+    return DCPU_run_with(self, options, skip_idle != 0);
+}
+
+struct AsyncRun {
+    PyObject_HEAD
+
+    /// the cpu being run, which is marked as running until the run is over
+    DCPU *dcpu;
+
+    /// the run itself, or NULL once it has been collected
+    background_run* job;
+
+    /// the event loop waiting on the run
+    PyObject *loop;
+
+    /// the future the run_result is delivered to
+    PyObject *future;
+};
+
+/// joins the run, if that hasn't happened already, and frees up the cpu
+static run_result
+AsyncRun_collect(AsyncRun *self)
+{
+    run_result result = self->job->finish();
+
+    delete self->job;
+    self->job = NULL;
+    self->dcpu->running = false;
+
+    return result;
+}
+
+static void
+AsyncRun_dealloc(AsyncRun* self)
+{
+    if (self->job != NULL) {
+        self->job->cancel();
+        AsyncRun_collect(self);
+    }
+
+    Py_XDECREF(self->dcpu);
+    Py_XDECREF(self->loop);
+    Py_XDECREF(self->future);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+/// called by the event loop once the run's descriptor is readable
+static PyObject *
+AsyncRun_complete(AsyncRun *self)
+{
+    if (self->job == NULL)
+        Py_RETURN_NONE;
+
+    PyObject *ret = PyObject_CallMethod(self->loop, "remove_reader", "i", self->job->fd());
+    if (ret == NULL)
+        return NULL;
+    Py_DECREF(ret);
+
+    run_result result = AsyncRun_collect(self);
+
+    PyObject *done = PyObject_CallMethod(self->future, "done", NULL);
+    if (done == NULL)
+        return NULL;
+
+    // a cancelled future has already been dealt with
+    int is_done = PyObject_IsTrue(done);
+    Py_DECREF(done);
+    if (is_done < 0)
+        return NULL;
+    if (is_done)
+        Py_RETURN_NONE;
+
+    PyObject *value = run_result_to_python(result);
+    if (value == NULL)
+        return NULL;
+
+    ret = PyObject_CallMethod(self->future, "set_result", "(N)", value);
+    if (ret == NULL)
+        return NULL;
+    Py_DECREF(ret);
+
+    Py_RETURN_NONE;
+}
+
+/// the future's done callback, which stops the run if it was cancelled
+static PyObject *
+AsyncRun_cancel(AsyncRun *self, PyObject *future)
+{
+    PyObject *cancelled = PyObject_CallMethod(future, "cancelled", NULL);
+    if (cancelled == NULL)
+        return NULL;
+
+    if (PyObject_IsTrue(cancelled) && self->job != NULL)
+        self->job->cancel();
+
+    Py_DECREF(cancelled);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef AsyncRun_methods[] = {
+    {"_complete", (PyCFunction)AsyncRun_complete, METH_NOARGS,
+     "Deliver the result of the finished run to the future"
+    },
+    {"_cancel", (PyCFunction)AsyncRun_cancel, METH_O,
+     "Stop the run if the future has been cancelled"
+    },
+    {NULL} /* Sentinel */
+};
+
+static PyTypeObject AsyncRunType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.async_run",        /* tp_name */
+    sizeof(AsyncRun),          /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)AsyncRun_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "a native run on a background thread, tied to an asyncio future", /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    AsyncRun_methods,          /* tp_methods */
+    0,                         /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    0,                         /* tp_init */
+    0,                         /* tp_alloc */
+    0,                         /* tp_new */
+};
+
+/**
+ * starts running the cpu on a background thread, returning a future on the
+ * running event loop that the run_result will be delivered to
+ */
+static PyObject *
+DCPU_start_async(DCPU* self, run_options options, bool skip_idle)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    std::vector<native_device*> devices;
+    if (DCPU_add_options(self, options, skip_idle, devices) < 0)
+        return NULL;
+
+    if (self->python_devices != 0) {
+        PyErr_SetString(PyExc_ValueError, "Only cpus with purely native devices can be run in the background");
+        return NULL;
+    }
+
+    PyObject *asyncio = PyImport_ImportModule("asyncio");
+    if (asyncio == NULL)
+        return NULL;
+
+    PyObject *loop = PyObject_CallMethod(asyncio, "get_running_loop", NULL);
+    Py_DECREF(asyncio);
+    if (loop == NULL)
+        return NULL;
+
+    AsyncRun *run = (AsyncRun *)AsyncRunType.tp_alloc(&AsyncRunType, 0);
+    if (run == NULL) {
+        Py_DECREF(loop);
+        return NULL;
+    }
+
+    run->loop = loop;
+    run->future = PyObject_CallMethod(loop, "create_future", NULL);
+    if (run->future == NULL) {
+        Py_DECREF(run);
+        return NULL;
+    }
+
+    try {
+        run->job = new background_run(*self->cpu, options);
+    } catch (std::system_error& e) {
+        PyErr_SetString(PyExc_OSError, e.what());
+        Py_DECREF(run);
+        return NULL;
+    }
+
+    Py_INCREF(self);
+    run->dcpu = self;
+    self->running = true;
+
+    PyObject *ret = PyObject_CallMethod(loop, "add_reader", "iN", run->job->fd(),
+                                        PyObject_GetAttrString((PyObject *)run, "_complete"));
+    if (ret == NULL) {
+        Py_DECREF(run);
+        return NULL;
+    }
+    Py_DECREF(ret);
+
+    ret = PyObject_CallMethod(run->future, "add_done_callback", "N",
+                              PyObject_GetAttrString((PyObject *)run, "_cancel"));
+    if (ret == NULL) {
+        PyObject *type, *value, *traceback;
+        PyErr_Fetch(&type, &value, &traceback);
+        Py_XDECREF(PyObject_CallMethod(loop, "remove_reader", "i", run->job->fd()));
+        PyErr_Restore(type, value, traceback);
+        Py_DECREF(run);
+        return NULL;
+    }
+    Py_DECREF(ret);
+
+    // the loop's reader and the future's callback keep the run alive
+    PyObject *future = run->future;
+    Py_INCREF(future);
+    Py_DECREF(run);
+    return future;
+}
+
+static PyObject *
+DCPU_run_async(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    unsigned long long cycles;
+    int skip_idle = 0;
+
+    static char *kwlist[] = {
+        const_cast<char *>("cycles"), const_cast<char *>("skip_idle"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "K|p", kwlist, &cycles, &skip_idle))
+        return NULL;
+
+    run_options options = run_for(cycles);
+    return DCPU_start_async(self, options, skip_idle != 0);
+}
+
+static PyObject *
+DCPU_run_until_async(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    run_options options = run_for(UINT64_MAX);
+    breakpoint_set set;
+    int skip_idle = 0;
+
+    if (parse_run_until(args, kwds, options, set, skip_idle) < 0)
+        return NULL;
+
+    return DCPU_start_async(self, options, skip_idle != 0);
+}
+
+/**
+ * raises an interrupt on the cpu; while it is running on another thread the
+ * message goes through the pending queue and is picked up between
+ * instructions, otherwise it is queued on the cpu straight away
+ */
+static int
+DCPU_raise(DCPU* self, std::uint16_t msg)
+{
+    // a device of the running cpu has it stopped, so can raise it directly
+    if (self->running && !PyDevice::calling(self->cpu)) {
+        if (!self->pending->push(msg)) {
+            PyErr_SetString(QueueOverflowError, "The pending interrupt queue is full");
+            return -1;
+        }
+        return 0;
+    }
+
+    if (DCPU_deliver_pending(self) < 0)
+        return -1;
+
+    try {
+        self->cpu->interrupt(msg);
+    } catch (galaxy::saturn::queue_overflow& e) {
+        PyErr_SetString(QueueOverflowError, e.what());
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *
+DCPU_interrupt(DCPU* self, PyObject *args)
+{
+    std::uint16_t msg;
+
+    // h = short int (checks for overflow)
+    if (!PyArg_ParseTuple(args, "H", &msg))
+        return NULL;
+
+    if (DCPU_raise(self, msg) < 0)
+        return NULL;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+DCPU_interrupt_many(DCPU* self, PyObject *args)
+{
+    PyObject *messages;
+
+    if (!PyArg_ParseTuple(args, "O", &messages))
+        return NULL;
+
+    PyObject *seq = PySequence_Fast(messages, "interrupt_many() expects an iterable of messages");
+    if (seq == NULL)
+        return NULL;
+
+    // validate everything before raising anything
+    std::vector<std::uint16_t> values;
+    values.reserve(PySequence_Fast_GET_SIZE(seq));
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+        long value = PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+        if (value == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return NULL;
+        }
+        if (value < 0 || value > 0xffff) {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_OverflowError, "Interrupt messages must be between 0 and 0xffff");
+            return NULL;
+        }
+        values.push_back(value);
+    }
+    Py_DECREF(seq);
+
+    for (std::size_t i = 0; i < values.size(); i++) {
+        if (DCPU_raise(self, values[i]) < 0)
+            return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+DCPU_attach_device(DCPU* self, PyObject *args)
+{
+    PyObject * dev = PyTuple_GetItem(args, 0);
+
+    if (dev == NULL) {
+        return NULL;
+    }
+
+    if (Py_TYPE(dev) != &DeviceType && !PyType_IsSubtype(Py_TYPE(dev), &DeviceType)) {
+        PyErr_SetString(PyExc_TypeError, "Argument must be an instance of Device or an instance of a subclass of Device");
+        return NULL;
+    }
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    Device* hw = (Device *) dev;
+
+    // a device can only be cycled by one cpu, on one thread
+    if (hw->owner != NULL) {
+        PyErr_SetString(PyExc_ValueError, "The device is already attached to a dcpu");
+        return NULL;
+    }
+
+    // python devices that override nothing never need the GIL
+    PyDevice* pydev = dynamic_cast<PyDevice *>(hw->hw);
+    if (pydev != NULL && Device_bind(pydev) < 0)
+        return NULL;
+
+    if (PyList_Append(self->devices, dev) < 0)
+        return NULL;
+
+    hw->owner = self;
+
+    native_device* native = dynamic_cast<native_device *>(hw->hw);
+    if (native != NULL)
+        native->host = self->cpu;
+
+    if (pydev != NULL) {
+        pydev->host = self->cpu;
+        if (!pydev->native())
+            self->python_devices++;
+    }
+
+    self->cpu->attach_device(hw->hw);
+
+    Py_RETURN_NONE;
+}
+
+
+
+static PyObject *
+DCPU_flash(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    PyObject *words;
+    const char *byteorder = NULL;
+    Py_ssize_t offset = 0;
+
+    static char *kwlist[] = {
+        const_cast<char *>("words"), const_cast<char *>("byteorder"),
+        const_cast<char *>("offset"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|zn", kwlist,
+                                     &words, &byteorder, &offset))
+        return NULL;
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    Py_ssize_t size = self->cpu->ram.size();
+    if (offset < 0 || offset > size) {
+        PyErr_SetString(PyExc_ValueError, "Flash offset out of range");
+        return NULL;
+    }
+
+    bool swap = false;
+    if (parse_byteorder(byteorder, words, swap) < 0)
+        return NULL;
+
+    std::uint16_t *ram = self->cpu->ram.data() + offset;
+
+    // buffers are copied straight into RAM, without any python objects
+    if (PyObject_CheckBuffer(words)) {
+        Py_buffer view;
+        const void *data;
+        std::vector<char> copy;
+        if (get_contiguous_buffer(words, &view, data, copy) < 0)
+            return NULL;
+
+        word_layout layout = byteorder != NULL ? LAYOUT_WORDS : layout_of(view, swap);
+
+        if (layout == LAYOUT_WORDS) {
+            if (view.len % 2 != 0) {
+                PyBuffer_Release(&view);
+                PyErr_SetString(PyExc_ValueError, "Raw images must hold a whole number of words");
+                return NULL;
+            }
+
+            Py_ssize_t count = view.len / 2;
+            if (count > size - offset) {
+                PyBuffer_Release(&view);
+                PyErr_SetString(PyExc_ValueError, "Image does not fit in RAM");
+                return NULL;
+            }
+
+            std::memcpy(ram, data, view.len);
+            PyBuffer_Release(&view);
+
+            if (swap) {
+                for (Py_ssize_t i = 0; i < count; i++) {
+                    ram[i] = (ram[i] >> 8) | (ram[i] << 8);
+                }
+            }
+
+            Py_RETURN_NONE;
+        }
+
+        // bytes and bytearrays hold one word per item, like any other sequence
+        if (layout == LAYOUT_BYTES) {
+            if (view.len > size - offset) {
+                PyBuffer_Release(&view);
+                PyErr_SetString(PyExc_ValueError, "Image does not fit in RAM");
+                return NULL;
+            }
+
+            const unsigned char *bytes = (const unsigned char *)data;
+            std::copy(bytes, bytes + view.len, ram);
+            PyBuffer_Release(&view);
+
+            Py_RETURN_NONE;
+        }
+
+        PyBuffer_Release(&view);
+    }
+
+    if (PySequence_Check(words) != 1) {
+        PyErr_SetString(PyExc_TypeError, "Non-sequence argument");
+        return NULL;
+    }
+
+    PyObject *seq = PySequence_Fast(words, "Non-sequence argument");
+    if (seq == NULL) {
+        return NULL;
+    }
+
+    Py_ssize_t length = PySequence_Fast_GET_SIZE(seq);
+    if (length > size - offset) {
+        Py_DECREF(seq);
+        PyErr_SetString(PyExc_ValueError, "Image does not fit in RAM");
+        return NULL;
+    }
+
+    std::vector<std::uint16_t> mem(length);
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+
+    for (Py_ssize_t i = 0; i < length; i++) {
+        if (PyLong_Check(items[i]) != 1) {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_TypeError, "Non-integer value in sequence");
+            return NULL;
+        }
+
+        mem[i] = PyLong_AsLong(items[i]);
+    }
+    Py_DECREF(seq);
+
+    std::copy(mem.begin(), mem.end(), ram);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+DCPU_snapshot(DCPU* self)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    State *state = (State *)StateType.tp_alloc(&StateType, 0);
+    if (state == NULL)
+        return NULL;
+
+    state->state = new dcpu_state;
+    save_state(*self->cpu, *state->state);
+
+    return (PyObject *)state;
+}
+
+static PyObject *
+DCPU_restore(DCPU* self, PyObject *args)
+{
+    State *state;
+
+    if (!PyArg_ParseTuple(args, "O!", &StateType, &state))
+        return NULL;
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    // a state holds no queued interrupts, so any queued now are dropped
+    self->cpu->reset();
+    DCPU_drop_pending(self);
+    load_state(*self->cpu, *state->state);
+
+    Py_RETURN_NONE;
+}
+
+/// builds a list of (start, stop) tuples, ready for slicing the cpu with
+static PyObject *
+ranges_to_python(const word_ranges& ranges)
+{
+    PyObject *list = PyList_New(ranges.size());
+    if (list == NULL)
+        return NULL;
+
+    for (std::size_t i = 0; i < ranges.size(); i++) {
+        PyObject *range = Py_BuildValue("(kk)", (unsigned long)ranges[i].first,
+                                        (unsigned long)ranges[i].second);
+        if (range == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+
+        PyList_SET_ITEM(list, i, range);
+    }
+
+    return list;
+}
+
+static PyObject *
+DCPU_take_dirty_ranges(DCPU* self)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    if (self->dirty == NULL)
+        self->dirty = new dirty_tracker;
+
+    word_ranges ranges;
+    self->dirty->take(*self->cpu, ranges);
+
+    return ranges_to_python(ranges);
+}
+
+static PyObject *
+DCPU_diff(DCPU* self, PyObject *args)
+{
+    State *state;
+
+    if (!PyArg_ParseTuple(args, "O!", &StateType, &state))
+        return NULL;
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    word_ranges ranges;
+    diff_words(self->cpu->ram.data(), state->state->ram, RAM_WORDS, ranges);
+
+    return ranges_to_python(ranges);
+}
+
+static PyObject *
+DCPU_reset(DCPU* self)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    self->cpu->reset();
+    DCPU_drop_pending(self);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+DCPU_watch(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    unsigned long address, length = 1;
+    int kind = WATCH_WRITE;
+
+    static char *kwlist[] = {
+        const_cast<char *>("address"), const_cast<char *>("length"),
+        const_cast<char *>("kind"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "k|ki", kwlist, &address, &length, &kind))
+        return NULL;
+
+    if (address >= RAM_WORDS || length > RAM_WORDS - address) {
+        PyErr_SetString(PyExc_ValueError, "Watched range out of range");
+        return NULL;
+    }
+
+    if (kind < 0 || kind > WATCH_ACCESS) {
+        PyErr_SetString(PyExc_ValueError, "kind must be WATCH_READ, WATCH_WRITE or WATCH_ACCESS");
+        return NULL;
+    }
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    if (self->watches == NULL)
+        self->watches = new watch_set;
+
+    self->watches->set(address, length, kind);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+DCPU_unwatch(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    PyObject *address = Py_None;
+    unsigned long length = 1;
+
+    static char *kwlist[] = {
+        const_cast<char *>("address"), const_cast<char *>("length"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|Ok", kwlist, &address, &length))
+        return NULL;
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    if (address == Py_None) {
+        delete self->watches;
+        self->watches = NULL;
+        Py_RETURN_NONE;
+    }
+
+    PyObject *unwatch_args = Py_BuildValue("(Oki)", address, length, 0);
+    if (unwatch_args == NULL)
+        return NULL;
+
+    PyObject *ret = DCPU_watch(self, unwatch_args, NULL);
+    Py_DECREF(unwatch_args);
+    return ret;
+}
+
+static PyObject *
+DCPU_start_trace(DCPU* self, PyObject *args, PyObject *kwds)
+{
+    Py_ssize_t capacity = 4096;
+
+    static char *kwlist[] = {const_cast<char *>("capacity"), NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|n", kwlist, &capacity))
+        return NULL;
+
+    if (capacity < 1) {
+        PyErr_SetString(PyExc_ValueError, "The trace capacity must be positive");
+        return NULL;
+    }
+
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    delete self->trace;
+    self->trace = new trace_buffer(capacity);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+DCPU_stop_trace(DCPU* self)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    delete self->trace;
+    self->trace = NULL;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+DCPU_drain_trace(DCPU* self)
+{
+    if (DCPU_check_running(self) < 0)
+        return NULL;
+
+    if (self->trace == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Tracing has not been started");
+        return NULL;
+    }
+
+    Trace *trace = (Trace *)TraceType.tp_alloc(&TraceType, 0);
+    if (trace == NULL)
+        return NULL;
+
+    trace->entries = new std::vector<trace_entry>;
+    trace->dropped = self->trace->drain(*trace->entries);
+    trace->shape[0] = trace->entries->size();
+    trace->strides[0] = sizeof(trace_entry);
+
+    return (PyObject *)trace;
+}
+
+static PyMethodDef DCPU_methods[] = {
+    {"cycle", (PyCFunction)DCPU_cycle, METH_NOARGS,
+     "Run the cpu for a single cycle"
+    },
+    {"run", (PyCFunction)DCPU_run, METH_VARARGS | METH_KEYWORDS,
+     "Run the cpu natively for up to the given number of cycles, "
+     "returning a run_result; with skip_idle, loops that can only spin "
+     "until a device acts are fast-forwarded to that point"
+    },
+    {"run_realtime", (PyCFunction)DCPU_run_realtime, METH_VARARGS | METH_KEYWORDS,
+     "Run the cpu at hz cycles per second for duration seconds, in "
+     "millisecond slices paced against a monotonic clock, returning a "
+     "realtime_result"
+    },
+    {"run_until", (PyCFunction)DCPU_run_until, METH_VARARGS | METH_KEYWORDS,
+     "Run the cpu natively until PC reaches one of the breakpoints, the "
+     "cycle limit is hit or, with stop_on_idle, it jumps onto itself; "
+     "skip_idle is as for run"
+    },
+    {"run_async", (PyCFunction)DCPU_run_async, METH_VARARGS | METH_KEYWORDS,
+     "Start run on a background thread, returning an awaitable future on "
+     "the running asyncio loop; cancelling it stops the run"
+    },
+    {"run_until_async", (PyCFunction)DCPU_run_until_async, METH_VARARGS | METH_KEYWORDS,
+     "Start run_until on a background thread, returning an awaitable "
+     "future on the running asyncio loop; cancelling it stops the run"
+    },
+    {"interrupt", (PyCFunction)DCPU_interrupt, METH_VARARGS,
+     "Trigger an interrupt on the DCPU; safe to call while it runs in the background"
+    },
+    {"interrupt_many", (PyCFunction)DCPU_interrupt_many, METH_VARARGS,
+     "Trigger an interrupt for each message in an iterable"
+    },
+    {"attach_device", (PyCFunction)DCPU_attach_device, METH_VARARGS,
+     "Attach a device to the DCPU"
+    },
+    {"flash", (PyCFunction)DCPU_flash, METH_VARARGS | METH_KEYWORDS,
+     "Flash the DCPU's memory with a sequence of integers, or with a raw "
+     "image in the given byteorder, starting at offset"
+    },
+    {"snapshot", (PyCFunction)DCPU_snapshot, METH_NOARGS,
+     "Save the DCPU's registers and memory into an immutable state object"
+    },
+    {"restore", (PyCFunction)DCPU_restore, METH_VARARGS,
+     "Load the DCPU's registers and memory from a state object"
+    },
+    {"take_dirty_ranges", (PyCFunction)DCPU_take_dirty_ranges, METH_NOARGS,
+     "Return the (start, stop) ranges of RAM modified since the last call, "
+     "all of RAM the first time"
+    },
+    {"diff", (PyCFunction)DCPU_diff, METH_VARARGS,
+     "Return the (start, stop) ranges where RAM differs from a state object"
+    },
+    {"reset", (PyCFunction)DCPU_reset, METH_NOARGS,
+     "Reset the DCPU's memory and registers"
+    },
+    {"watch", (PyCFunction)DCPU_watch, METH_VARARGS | METH_KEYWORDS,
+     "Stop native runs after an instruction reads (WATCH_READ), writes "
+     "(WATCH_WRITE) or does either (WATCH_ACCESS) to length words from "
+     "address; an access is caught as its instruction comes up, so one "
+     "pre-empted by an interrupt stops the run before it is made"
+    },
+    {"unwatch", (PyCFunction)DCPU_unwatch, METH_VARARGS | METH_KEYWORDS,
+     "Stop watching length words from address, or everything when no "
+     "address is given"
+    },
+    {"start_trace", (PyCFunction)DCPU_start_trace, METH_VARARGS | METH_KEYWORDS,
+     "Record every instruction the DCPU executes into a ring buffer "
+     "holding the given number of the most recent ones"
+    },
+    {"stop_trace", (PyCFunction)DCPU_stop_trace, METH_NOARGS,
+     "Stop tracing and throw away any undrained entries"
+    },
+    {"drain_trace", (PyCFunction)DCPU_drain_trace, METH_NOARGS,
+     "Empty the trace ring buffer into a trace object, oldest entry first"
+    },
+    {"get_registers", (PyCFunction)DCPU_get_registers, METH_NOARGS,
+     "Copy all twelve registers into an array('H'), in the order "
+     "A B C X Y Z I J PC SP EX IA"
+    },
+    {"set_registers", (PyCFunction)DCPU_set_registers, METH_VARARGS,
+     "Load all twelve registers from a buffer or sequence of words"
+    },
+    {NULL} /* Sentinel */
+};
+
+static Py_ssize_t
+DCPU_length (DCPU *self)
+{
+    return self->cpu->ram.size();
+}
+
+static PyObject *
+DCPU_item (DCPU *self, Py_ssize_t i)
+{
+    if (i < 0 || i >= self->cpu->ram.size()) {
+        PyErr_SetString(PyExc_IndexError, "RAM index out of range");
+        return NULL;
+    }
+
+    PyObject *val = PyLong_FromLong(self->cpu->ram[i]);
+    if (val == NULL)
+        return NULL;
+
+    return val;
 }
 
 static int
-DCPU_setEX(DCPU *self, PyObject *value, void *closure)
+DCPU_ass_item (DCPU *self, Py_ssize_t i, PyObject *val)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+    if (i < 0 || i >= self->cpu->ram.size()) {
+        PyErr_SetString(PyExc_IndexError, "RAM assignment index out of range");
         return -1;
     }
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
+    if (val == NULL) {
+        PyErr_SetString(PyExc_TypeError, "RAM words cannot be deleted");
         return -1;
     }
 
-    self->cpu->EX = PyLong_AsLong(value);
+    if (!PyLong_Check(val)) {
+        PyErr_SetString(PyExc_TypeError, "RAM words must be integers");
+        return -1;
+    }
+
+    if (DCPU_check_stopped(self) < 0)
+        return -1;
+
+    std::uint16_t word = PyLong_AsLong(val);
+    self->cpu->ram[i] = word;
 
     return 0;
 }
 
 static PyObject *
-DCPU_getIA(DCPU *self, void *closure)
+DCPU_subscript(DCPU *self, PyObject *key)
 {
-    PyObject *IA = PyLong_FromLong(self->cpu->IA);
-    if (IA == NULL) {
+    Py_ssize_t size = self->cpu->ram.size();
+
+    if (PyIndex_Check(key)) {
+        Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (i == -1 && PyErr_Occurred())
+            return NULL;
+
+        if (i < 0)
+            i += size;
+
+        return DCPU_item(self, i);
+    }
+
+    if (!PySlice_Check(key)) {
+        PyErr_SetString(PyExc_TypeError, "RAM indices must be integers or slices");
         return NULL;
     }
 
-    return IA;
+    Py_ssize_t start, stop, step, count;
+    if (PySlice_GetIndicesEx(key, size, &start, &stop, &step, &count) < 0)
+        return NULL;
+
+    const std::uint16_t *ram = self->cpu->ram.data();
+    if (step == 1)
+        return array_from_words(ram + start, count);
+
+    std::vector<std::uint16_t> words(count);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        words[i] = ram[start + i * step];
+    }
+
+    return array_from_words(words.data(), count);
 }
 
+/**
+ * copies `value` into the RAM words selected by a slice; buffers follow the
+ * rules of flash(), so 16 bit items are copied word for word and bytes give
+ * one word each, and anything else must be a sequence of integers
+ */
 static int
-DCPU_setIA(DCPU *self, PyObject *value, void *closure)
+DCPU_ass_slice(DCPU *self, Py_ssize_t start, Py_ssize_t step, Py_ssize_t count, PyObject *value)
 {
-    if (value == NULL) {
-        PyErr_SetString(PyExc_TypeError, "Cannot delete the first attribute");
+    if (DCPU_check_stopped(self) < 0)
         return -1;
+
+    std::uint16_t *ram = self->cpu->ram.data();
+
+    if (PyObject_CheckBuffer(value)) {
+        Py_buffer view;
+        const void *data;
+        std::vector<char> copy;
+        if (get_contiguous_buffer(value, &view, data, copy) < 0)
+            return -1;
+
+        bool swap = false;
+        word_layout layout = layout_of(view, swap);
+
+        if (layout != LAYOUT_SEQUENCE && view.len != count * view.itemsize) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, "RAM slice assignment cannot change the size of RAM");
+            return -1;
+        }
+
+        if (layout == LAYOUT_WORDS) {
+            const std::uint16_t *words = (const std::uint16_t *)data;
+            if (step == 1) {
+                std::memmove(ram + start, words, view.len);
+            } else {
+                for (Py_ssize_t i = 0; i < count; i++) {
+                    ram[start + i * step] = words[i];
+                }
+            }
+
+            PyBuffer_Release(&view);
+
+            if (swap) {
+                for (Py_ssize_t i = 0; i < count; i++) {
+                    std::uint16_t& word = ram[start + i * step];
+                    word = (word >> 8) | (word << 8);
+                }
+            }
+
+            return 0;
+        }
+
+        if (layout == LAYOUT_BYTES) {
+            const unsigned char *bytes = (const unsigned char *)data;
+            for (Py_ssize_t i = 0; i < count; i++) {
+                ram[start + i * step] = bytes[i];
+            }
+
+            PyBuffer_Release(&view);
+            return 0;
+        }
+
+        PyBuffer_Release(&view);
     }
 
-    if (! PyLong_Check(value)) {
-        PyErr_SetString(PyExc_TypeError,
-                        "The first attribute value must be an integer");
+    PyObject *seq = PySequence_Fast(value, "RAM slices can only be assigned buffers or sequences");
+    if (seq == NULL)
+        return -1;
+
+    if (PySequence_Fast_GET_SIZE(seq) != count) {
+        Py_DECREF(seq);
+        PyErr_SetString(PyExc_ValueError, "RAM slice assignment cannot change the size of RAM");
         return -1;
     }
 
-    self->cpu->IA = PyLong_AsLong(value);
+    // convert everything before writing, so a bad item leaves RAM untouched
+    std::vector<std::uint16_t> words(count);
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        long word = PyLong_AsLong(items[i]);
+        if (word == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return -1;
+        }
+
+        if (word < 0 || word > 0xffff) {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_OverflowError, "RAM words must be between 0 and 0xffff");
+            return -1;
+        }
+
+        words[i] = word;
+    }
+    Py_DECREF(seq);
+
+    for (Py_ssize_t i = 0; i < count; i++) {
+        ram[start + i * step] = words[i];
+    }
 
     return 0;
 }
 
-static PyGetSetDef DCPU_getseters[] = {
-    {"A",
-     (getter)DCPU_getA, (setter)DCPU_setA,
-     "register A",
-     NULL},
-    {"B",
-     (getter)DCPU_getB, (setter)DCPU_setB,
-     "register B",
-     NULL},
-    {"C",
-     (getter)DCPU_getC, (setter)DCPU_setC,
-     "register C",
-     NULL},
-    {"X",
-     (getter)DCPU_getX, (setter)DCPU_setX,
-     "register X",
-     NULL},
-    {"Y",
-     (getter)DCPU_getY, (setter)DCPU_setY,
-     "register Y",
-     NULL},
-    {"Z",
-     (getter)DCPU_getZ, (setter)DCPU_setZ,
-     "register Z",
-     NULL},
-    {"I",
-     (getter)DCPU_getI, (setter)DCPU_setI,
-     "register I",
-     NULL},
-    {"J",
-     (getter)DCPU_getJ, (setter)DCPU_setJ,
-     "register J",
-     NULL},
-    {"PC",
-     (getter)DCPU_getPC, (setter)DCPU_setPC,
-     "register PC",
-     NULL},
-    {"SP",
-     (getter)DCPU_getSP, (setter)DCPU_setSP,
-     "register SP",
-     NULL},
-    {"EX",
-     (getter)DCPU_getEX, (setter)DCPU_setEX,
-     "register EX",
-     NULL},
-    {"IA",
-     (getter)DCPU_getIA, (setter)DCPU_setIA,
-     "register IA",
-     NULL},
-    {NULL}  /* Sentinel */
+static int
+DCPU_ass_subscript(DCPU *self, PyObject *key, PyObject *value)
+{
+    Py_ssize_t size = self->cpu->ram.size();
+
+    if (PyIndex_Check(key)) {
+        Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (i == -1 && PyErr_Occurred())
+            return -1;
+
+        if (i < 0)
+            i += size;
+
+        return DCPU_ass_item(self, i, value);
+    }
+
+    if (!PySlice_Check(key)) {
+        PyErr_SetString(PyExc_TypeError, "RAM indices must be integers or slices");
+        return -1;
+    }
+
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "RAM words cannot be deleted");
+        return -1;
+    }
+
+    Py_ssize_t start, stop, step, count;
+    if (PySlice_GetIndicesEx(key, size, &start, &stop, &step, &count) < 0)
+        return -1;
+
+    return DCPU_ass_slice(self, start, step, count, value);
+}
+
+static PySequenceMethods DCPU_as_sequence = {
+    (lenfunc)DCPU_length,                       /* sq_length */
+    0,                                          /* sq_concat */
+    0,                                          /* sq_repeat */
+    (ssizeargfunc)DCPU_item,                    /* sq_item */
+    0,                                          /* sq_slice */
+    (ssizeobjargproc)DCPU_ass_item,             /* sq_ass_item */
+    0,                                          /* sq_ass_slice */
+    0,                                          /* sq_contains */
+    0,                                          /* sq_inplace_concat */
+    0,                                          /* sq_inplace_repeat */
+};
+
+static PyMappingMethods DCPU_as_mapping = {
+    (lenfunc)DCPU_length,                       /* mp_length */
+    (binaryfunc)DCPU_subscript,                 /* mp_subscript */
+    (objobjargproc)DCPU_ass_subscript,          /* mp_ass_subscript */
+};
+
+/// the DCPU-16 address space is always 64K words
+static Py_ssize_t DCPU_ram_shape[] = {0x10000};
+static Py_ssize_t DCPU_ram_strides[] = {sizeof(std::uint16_t)};
+
+static int
+DCPU_getbuffer(DCPU *self, Py_buffer *view, int flags)
+{
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+
+    view->buf = self->cpu->ram.data();
+    view->len = self->cpu->ram.size() * sizeof(std::uint16_t);
+    view->readonly = 0;
+    view->itemsize = sizeof(std::uint16_t);
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>("H") : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? DCPU_ram_shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? DCPU_ram_strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    return 0;
+}
+
+static PyBufferProcs DCPU_as_buffer = {
+    (getbufferproc)DCPU_getbuffer,              /* bf_getbuffer */
+    0,                                          /* bf_releasebuffer */
+};
+
+static PyTypeObject DCPUType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "saturn.dcpu",             /* tp_name */
+    sizeof(DCPU),              /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)DCPU_dealloc,  /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    &DCPU_as_sequence,         /* tp_as_sequence */
+    &DCPU_as_mapping,          /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    &DCPU_as_buffer,           /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+        Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "dcpu objects",            /* tp_doc */
+    (traverseproc)DCPU_traverse, /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    DCPU_methods,              /* tp_methods */
+    0,                         /* tp_members */
+    DCPU_getseters,            /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)DCPU_init,       /* tp_init */
+    0,                         /* tp_alloc */
+    DCPU_new,                  /* tp_new */
 };
 
+/**
+ * runs `count` dcpu objects on the thread pool, returning a list of their
+ * run_results
+ */
 static PyObject *
-DCPU_cycle(DCPU* self)
+run_cpus(PyObject **items, Py_ssize_t count, const run_options& options, unsigned threads)
 {
-    try {
-        self->cpu->cycle();
-    } catch (galaxy::saturn::invalid_opcode& e) {
-        PyErr_SetString(InvalidOpcodeError, e.what());
-        return NULL;
-    } catch (galaxy::saturn::queue_overflow& e) {
-        PyErr_SetString(QueueOverflowError, e.what());
+    std::vector<galaxy::saturn::dcpu*> cpus;
+
+    for (Py_ssize_t i = 0; i < count; i++) {
+        if (!PyObject_TypeCheck(items[i], &DCPUType)) {
+            PyErr_SetString(PyExc_TypeError, "cpus must be a sequence of dcpu objects");
+            return NULL;
+        }
+
+        DCPU *dcpu = (DCPU *)items[i];
+        if (DCPU_bind_devices(dcpu) < 0)
+            return NULL;
+
+        if (dcpu->python_devices != 0) {
+            PyErr_SetString(PyExc_ValueError, "Only cpus with purely native devices can be run in a batch");
+            return NULL;
+        }
+
+        if (DCPU_check_running(dcpu) < 0)
+            return NULL;
+
+        cpus.push_back(dcpu->cpu);
+    }
+
+    std::vector<galaxy::saturn::dcpu*> sorted(cpus);
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        PyErr_SetString(PyExc_ValueError, "A cpu cannot appear in a batch more than once");
         return NULL;
     }
 
-    Py_RETURN_NONE;
-}
+    for (Py_ssize_t i = 0; i < count; i++) {
+        ((DCPU *)items[i])->running = true;
+    }
 
-static PyObject *
-DCPU_interrupt(DCPU* self, PyObject *args)
-{
-    std::uint16_t msg;
+    std::vector<run_result> results;
 
-    // h = short int (checks for overflow)
-    if (!PyArg_ParseTuple(args, "H", &msg))
-        return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    results = run_batch(cpus, options, threads);
+    Py_END_ALLOW_THREADS
 
-    try {
-        self->cpu->interrupt(msg);
-    } catch (galaxy::saturn::queue_overflow& e) {
-        PyErr_SetString(QueueOverflowError, e.what());
+    for (Py_ssize_t i = 0; i < count; i++) {
+        ((DCPU *)items[i])->running = false;
+    }
+
+    PyObject *list = PyList_New(count);
+    if (list == NULL)
         return NULL;
+
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyObject *result = run_result_to_python(results[i]);
+        if (result == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+
+        PyList_SET_ITEM(list, i, result);
     }
 
-    Py_RETURN_NONE;
+    return list;
 }
 
 static PyObject *
-DCPU_attach_device(DCPU* self, PyObject *args)
+saturn_batch(PyObject *module, PyObject *args, PyObject *kwds)
 {
-    PyObject * dev = PyTuple_GetItem(args, 0);
+    PyObject *sequence;
+    unsigned long long cycles;
+    unsigned int threads = 0;
 
-    if (dev == NULL) {
+    static char *kwlist[] = {
+        const_cast<char *>("cpus"), const_cast<char *>("cycles"),
+        const_cast<char *>("threads"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OK|I", kwlist, &sequence, &cycles, &threads))
         return NULL;
-    }
 
-    if (Py_TYPE(dev) != &DeviceType && !PyType_IsSubtype(Py_TYPE(dev), &DeviceType)) {
-        PyErr_SetString(PyExc_TypeError, "Argument must be an instance of Device or an instance of a subclass of Device");
+    PyObject *seq = PySequence_Fast(sequence, "cpus must be a sequence of dcpu objects");
+    if (seq == NULL)
         return NULL;
-    }
 
-    Device* hw = (Device *) dev;
-    self->cpu->attach_device(hw->hw);
+    run_options options = run_for(cycles);
+    PyObject *results = run_cpus(PySequence_Fast_ITEMS(seq), PySequence_Fast_GET_SIZE(seq),
+                                 options, threads);
 
-    Py_RETURN_NONE;
+    Py_DECREF(seq);
+    return results;
+}
+
+struct DCPUArray {
+    PyObject_HEAD
+
+    /// the list of dcpu objects making up the array
+    PyObject *lanes;
+};
+
+static void
+DCPUArray_dealloc(DCPUArray* self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->lanes);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int
+DCPUArray_traverse(DCPUArray *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->lanes);
+    return 0;
 }
 
+static int
+DCPUArray_clear(DCPUArray *self)
+{
+    Py_CLEAR(self->lanes);
+    return 0;
+}
 
 static PyObject *
-DCPU_flash(DCPU* self, PyObject *args)
+DCPUArray_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-    PyObject * words = PyTuple_GetItem(args, 0);
+    Py_ssize_t count;
+    PyObject *image = Py_None;
+
+    static char *kwlist[] = {
+        const_cast<char *>("count"), const_cast<char *>("image"), NULL
+    };
 
-    if (words == NULL) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "n|O", kwlist, &count, &image))
         return NULL;
-    }
 
-    if (PySequence_Check(words) != 1) {
-        PyErr_SetString(PyExc_TypeError, "Non-sequence argument");
+    if (count < 1) {
+        PyErr_SetString(PyExc_ValueError, "A dcpu_array needs at least one cpu");
         return NULL;
     }
 
-    std::vector<std::uint16_t> mem;
+    DCPUArray *self = (DCPUArray *)type->tp_alloc(type, 0);
+    if (self == NULL)
+        return NULL;
 
-    int length = PySequence_Size(words);
-    if (length < 0) {
+    self->lanes = PyList_New(count);
+    if (self->lanes == NULL) {
+        Py_DECREF(self);
         return NULL;
     }
 
-    for (int i = 0; i < length; i++) {
-        PyObject * word = PySequence_GetItem(words, i);
-        if (word == NULL) {
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyObject *lane = PyObject_CallObject((PyObject *)&DCPUType, NULL);
+        if (lane == NULL) {
+            Py_DECREF(self);
             return NULL;
         }
 
-        if (PyLong_Check(word) != 1) {
-            Py_DECREF(word);
-            PyErr_SetString(PyExc_TypeError, "Non-integer value in sequence");
+        PyList_SET_ITEM(self->lanes, i, lane);
+    }
+
+    // the image is flashed once and then copied natively to every other lane
+    if (image != Py_None) {
+        DCPU *first = (DCPU *)PyList_GET_ITEM(self->lanes, 0);
+
+        PyObject *flash_args = PyTuple_Pack(1, image);
+        if (flash_args == NULL) {
+            Py_DECREF(self);
             return NULL;
         }
 
-        mem.push_back(PyLong_AsLong(word));
-        Py_DECREF(word);
+        PyObject *ret = DCPU_flash(first, flash_args, NULL);
+        Py_DECREF(flash_args);
+        if (ret == NULL) {
+            Py_DECREF(self);
+            return NULL;
+        }
+        Py_DECREF(ret);
+
+        for (Py_ssize_t i = 1; i < count; i++) {
+            ((DCPU *)PyList_GET_ITEM(self->lanes, i))->cpu->ram = first->cpu->ram;
+        }
     }
 
-    self->cpu->flash(mem.begin(), mem.end());
+    return (PyObject *)self;
+}
 
-    Py_RETURN_NONE;
+static PyObject *
+DCPUArray_snapshot_registers(DCPUArray *self)
+{
+    Py_ssize_t count = PyList_GET_SIZE(self->lanes);
+    std::vector<std::uint16_t> words(REGISTER_COUNT * count);
+
+    for (Py_ssize_t i = 0; i < count; i++) {
+        std::uint16_t registers[REGISTER_COUNT];
+        save_registers(*((DCPU *)PyList_GET_ITEM(self->lanes, i))->cpu, registers);
+
+        for (int r = 0; r < REGISTER_COUNT; r++) {
+            words[r * count + i] = registers[r];
+        }
+    }
+
+    return array_from_words(words.data(), words.size());
 }
 
 static PyObject *
-DCPU_reset(DCPU* self)
+DCPUArray_restore_registers(DCPUArray *self, PyObject *args)
 {
-    self->cpu->reset();
+    PyObject *value;
+    if (!PyArg_ParseTuple(args, "O", &value))
+        return NULL;
+
+    Py_ssize_t count = PyList_GET_SIZE(self->lanes);
+    std::vector<std::uint16_t> data(REGISTER_COUNT * count);
+    if (words_from_object(value, data.data(), data.size()) < 0)
+        return NULL;
+
+    for (Py_ssize_t i = 0; i < count; i++) {
+        if (DCPU_check_running((DCPU *)PyList_GET_ITEM(self->lanes, i)) < 0)
+            return NULL;
+    }
+
+    for (Py_ssize_t i = 0; i < count; i++) {
+        std::uint16_t registers[REGISTER_COUNT];
+        for (int r = 0; r < REGISTER_COUNT; r++) {
+            registers[r] = data[r * count + i];
+        }
+
+        load_registers(*((DCPU *)PyList_GET_ITEM(self->lanes, i))->cpu, registers);
+    }
 
     Py_RETURN_NONE;
 }
 
-static PyMethodDef DCPU_methods[] = {
-    {"cycle", (PyCFunction)DCPU_cycle, METH_NOARGS,
-     "Run the cpu for a single cycle"
-    },
-    {"interrupt", (PyCFunction)DCPU_interrupt, METH_VARARGS,
-     "Trigger an interrupt on the DCPU"
-    },
-    {"attach_device", (PyCFunction)DCPU_attach_device, METH_VARARGS,
-     "Attach a device to the DCPU"
+static PyObject *
+DCPUArray_run(DCPUArray* self, PyObject *args, PyObject *kwds)
+{
+    unsigned long long cycles;
+    unsigned int threads = 0;
+
+    static char *kwlist[] = {
+        const_cast<char *>("cycles"), const_cast<char *>("threads"), NULL
+    };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "K|I", kwlist, &cycles, &threads))
+        return NULL;
+
+    run_options options = run_for(cycles);
+    return run_cpus(PySequence_Fast_ITEMS(self->lanes), PyList_GET_SIZE(self->lanes),
+                    options, threads);
+}
+
+static PyMethodDef DCPUArray_methods[] = {
+    {"snapshot_registers", (PyCFunction)DCPUArray_snapshot_registers, METH_NOARGS,
+     "Copy the registers of every lane into a new array('H') laid out "
+     "register by register (all the As, then all the Bs, ...), i.e. shape "
+     "(12, len). Writes to the copy do not reach the lanes; pass it to "
+     "restore_registers to load it back"
     },
-    {"flash", (PyCFunction)DCPU_flash, METH_VARARGS,
-     "Flash the DCPU's memory with a sequence of integers"
+    {"restore_registers", (PyCFunction)DCPUArray_restore_registers, METH_VARARGS,
+     "Load the registers of every lane from a buffer or sequence of words "
+     "laid out as snapshot_registers returns them"
     },
-    {"reset", (PyCFunction)DCPU_reset, METH_NOARGS,
-     "Reset the DCPU's memory and registers"
+    {"run", (PyCFunction)DCPUArray_run, METH_VARARGS | METH_KEYWORDS,
+     "Run every lane for up to the given number of cycles on the thread "
+     "pool, returning a list of run_results; like saturn.batch, lanes "
+     "with python devices are refused"
     },
     {NULL} /* Sentinel */
 };
 
 static Py_ssize_t
-DCPU_length (DCPU *self)
+DCPUArray_length(DCPUArray *self)
 {
-    return self->cpu->ram.size();
+    return PyList_GET_SIZE(self->lanes);
 }
 
 static PyObject *
-DCPU_item (DCPU *self, Py_ssize_t i)
+DCPUArray_item(DCPUArray *self, Py_ssize_t i)
 {
-    if (i < 0 || i >= self->cpu->ram.size()) {
-        PyErr_SetString(PyExc_IndexError, "RAM index out of range");
-        return NULL;
-    }
-
-    PyObject *val = PyLong_FromLong(self->cpu->ram[i]);
-    if (val == NULL)
+    if (i < 0 || i >= PyList_GET_SIZE(self->lanes)) {
+        PyErr_SetString(PyExc_IndexError, "dcpu_array index out of range");
         return NULL;
-
-    return val;
-}
-
-static int
-DCPU_ass_item (DCPU *self, Py_ssize_t i, PyObject *val)
-{
-    if (i < 0 || i >= self->cpu->ram.size()) {
-        PyErr_SetString(PyExc_IndexError, "RAM assignment index out of range");
-        return -1;
-    }
-
-    if (!PyLong_Check(val)) {
-        return -1;
     }
 
-    std::uint16_t word = PyLong_AsLong(val);
-    self->cpu->ram[i] = word;
-
-    return 0;
+    PyObject *lane = PyList_GET_ITEM(self->lanes, i);
+    Py_INCREF(lane);
+    return lane;
 }
 
-static PySequenceMethods DCPU_as_sequence = {
-    (lenfunc)DCPU_length,                       /* sq_length */
+static PySequenceMethods DCPUArray_as_sequence = {
+    (lenfunc)DCPUArray_length,                  /* sq_length */
     0,                                          /* sq_concat */
     0,                                          /* sq_repeat */
-    (ssizeargfunc)DCPU_item,                    /* sq_item */
+    (ssizeargfunc)DCPUArray_item,               /* sq_item */
     0,                                          /* sq_slice */
-    (ssizeobjargproc)DCPU_ass_item,             /* sq_ass_item */
+    0,                                          /* sq_ass_item */
     0,                                          /* sq_ass_slice */
     0,                                          /* sq_contains */
     0,                                          /* sq_inplace_concat */
     0,                                          /* sq_inplace_repeat */
 };
 
-static PyTypeObject DCPUType = {
+static PyTypeObject DCPUArrayType = {
     PyVarObject_HEAD_INIT(NULL, 0)
-    "saturn.dcpu",             /* tp_name */
-    sizeof(DCPU),              /* tp_basicsize */
+    "saturn.dcpu_array",       /* tp_name */
+    sizeof(DCPUArray),         /* tp_basicsize */
     0,                         /* tp_itemsize */
-    (destructor)DCPU_dealloc,  /* tp_dealloc */
+    (destructor)DCPUArray_dealloc, /* tp_dealloc */
     0,                         /* tp_print */
     0,                         /* tp_getattr */
     0,                         /* tp_setattr */
     0,                         /* tp_reserved */
     0,                         /* tp_repr */
     0,                         /* tp_as_number */
-    &DCPU_as_sequence,         /* tp_as_sequence */
+    &DCPUArray_as_sequence,    /* tp_as_sequence */
     0,                         /* tp_as_mapping */
     0,                         /* tp_hash  */
     0,                         /* tp_call */
@@ -922,25 +4527,36 @@ static PyTypeObject DCPUType = {
     0,                         /* tp_getattro */
     0,                         /* tp_setattro */
     0,                         /* tp_as_buffer */
-    Py_TPFLAGS_DEFAULT,        /* tp_flags */
-    "dcpu objects",            /* tp_doc */
-    0,                         /* tp_traverse */
-    0,                         /* tp_clear */
+    Py_TPFLAGS_DEFAULT |
+        Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "a fixed number of dcpus, typically running the same image, with "
+    "snapshots of their registers taken structure-of-arrays style; "
+    "each lane is a dcpu whose RAM is live through the buffer protocol", /* tp_doc */
+    (traverseproc)DCPUArray_traverse, /* tp_traverse */
+    (inquiry)DCPUArray_clear,  /* tp_clear */
     0,                         /* tp_richcompare */
     0,                         /* tp_weaklistoffset */
     0,                         /* tp_iter */
     0,                         /* tp_iternext */
-    DCPU_methods,              /* tp_methods */
+    DCPUArray_methods,         /* tp_methods */
     0,                         /* tp_members */
-    DCPU_getseters,            /* tp_getset */
+    0,                         /* tp_getset */
     0,                         /* tp_base */
     0,                         /* tp_dict */
     0,                         /* tp_descr_get */
     0,                         /* tp_descr_set */
     0,                         /* tp_dictoffset */
-    (initproc)DCPU_init,       /* tp_init */
+    0,                         /* tp_init */
     0,                         /* tp_alloc */
-    DCPU_new,                  /* tp_new */
+    DCPUArray_new,             /* tp_new */
+};
+
+static PyMethodDef saturn_methods[] = {
+    {"batch", (PyCFunction)saturn_batch, METH_VARARGS | METH_KEYWORDS,
+     "Run each of a sequence of dcpus for up to the given number of cycles "
+     "on a pool of native threads, returning a list of run_results"
+    },
+    {NULL} /* Sentinel */
 };
 
 static PyModuleDef saturnmodule = {
@@ -948,7 +4564,7 @@ static PyModuleDef saturnmodule = {
     "saturn",
     "wrapper for galaxy's emulator",
     -1,
-    NULL, NULL, NULL, NULL, NULL
+    saturn_methods, NULL, NULL, NULL, NULL
 };
 
 PyMODINIT_FUNC
@@ -964,11 +4580,65 @@ PyInit_saturn(void)
         return NULL;
     }
 
+    PyTypeObject *native_types[] = {&ClockType, &KeyboardType, &LEM1802Type, &M35FDType};
+    for (auto type : native_types) {
+        if (PyType_Ready(type) < 0) {
+            return NULL;
+        }
+    }
+
+    if (PyType_Ready(&StateType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&DCPUArrayType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&TraceType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&ProfileType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&CountersType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&AsyncRunType) < 0) {
+        return NULL;
+    }
+
+    if (RunResultType.tp_name == NULL) {
+        if (PyStructSequence_InitType2(&RunResultType, &RunResult_desc) < 0) {
+            return NULL;
+        }
+    }
+
+    if (RealtimeResultType.tp_name == NULL) {
+        if (PyStructSequence_InitType2(&RealtimeResultType, &RealtimeResult_desc) < 0) {
+            return NULL;
+        }
+    }
+
     m = PyModule_Create(&saturnmodule);
     if (m == NULL) {
         return NULL;
     }
 
+    PyObject *array = PyImport_ImportModule("array");
+    if (array == NULL) {
+        return NULL;
+    }
+
+    ArrayType = PyObject_GetAttrString(array, "array");
+    Py_DECREF(array);
+    if (ArrayType == NULL) {
+        return NULL;
+    }
+
     Py_INCREF(&DCPUType);
     if (PyModule_AddObject(m, "dcpu", (PyObject *)&DCPUType) < 0) {
         return NULL;
@@ -979,6 +4649,70 @@ PyInit_saturn(void)
         return NULL;
     }
 
+    const char *native_names[] = {"clock", "keyboard", "lem1802", "m35fd"};
+    for (int i = 0; i < 4; i++) {
+        Py_INCREF(native_types[i]);
+        if (PyModule_AddObject(m, native_names[i], (PyObject *)native_types[i]) < 0) {
+            return NULL;
+        }
+    }
+
+    if (PyModule_AddIntConstant(m, "KEY_BACKSPACE", KEY_BACKSPACE) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_RETURN", KEY_RETURN) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_INSERT", KEY_INSERT) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_DELETE", KEY_DELETE) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_UP", KEY_UP) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_DOWN", KEY_DOWN) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_LEFT", KEY_LEFT) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_RIGHT", KEY_RIGHT) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_SHIFT", KEY_SHIFT) < 0 ||
+        PyModule_AddIntConstant(m, "KEY_CONTROL", KEY_CONTROL) < 0) {
+        return NULL;
+    }
+
+    Py_INCREF(&ProfileType);
+    if (PyModule_AddObject(m, "profile", (PyObject *)&ProfileType) < 0) {
+        return NULL;
+    }
+
+    Py_INCREF(&TraceType);
+    if (PyModule_AddObject(m, "trace", (PyObject *)&TraceType) < 0) {
+        return NULL;
+    }
+
+    Py_INCREF(&DCPUArrayType);
+    if (PyModule_AddObject(m, "dcpu_array", (PyObject *)&DCPUArrayType) < 0) {
+        return NULL;
+    }
+
+    Py_INCREF(&StateType);
+    if (PyModule_AddObject(m, "state", (PyObject *)&StateType) < 0) {
+        return NULL;
+    }
+
+    Py_INCREF(&RunResultType);
+    if (PyModule_AddObject(m, "run_result", (PyObject *)&RunResultType) < 0) {
+        return NULL;
+    }
+
+    Py_INCREF(&RealtimeResultType);
+    if (PyModule_AddObject(m, "realtime_result", (PyObject *)&RealtimeResultType) < 0) {
+        return NULL;
+    }
+
+    if (PyModule_AddIntConstant(m, "STOP_BUDGET", STOP_BUDGET) < 0 ||
+        PyModule_AddIntConstant(m, "STOP_INVALID_OPCODE", STOP_INVALID_OPCODE) < 0 ||
+        PyModule_AddIntConstant(m, "STOP_QUEUE_OVERFLOW", STOP_QUEUE_OVERFLOW) < 0 ||
+        PyModule_AddIntConstant(m, "STOP_BREAKPOINT", STOP_BREAKPOINT) < 0 ||
+        PyModule_AddIntConstant(m, "STOP_IDLE", STOP_IDLE) < 0 ||
+        PyModule_AddIntConstant(m, "STOP_WATCHPOINT", STOP_WATCHPOINT) < 0 ||
+        PyModule_AddIntConstant(m, "STOP_CANCELLED", STOP_CANCELLED) < 0 ||
+        PyModule_AddIntConstant(m, "WATCH_READ", WATCH_READ) < 0 ||
+        PyModule_AddIntConstant(m, "WATCH_WRITE", WATCH_WRITE) < 0 ||
+        PyModule_AddIntConstant(m, "WATCH_ACCESS", WATCH_ACCESS) < 0) {
+        return NULL;
+    }
+
     InvalidOpcodeError = PyErr_NewException("saturn.InvalidOpcodeError", NULL, NULL);
     if (InvalidOpcodeError == NULL) {
         return NULL;
@@ -989,5 +4723,15 @@ PyInit_saturn(void)
         return NULL;
     }
 
+    QueueOverflowError = PyErr_NewException("saturn.QueueOverflowError", NULL, NULL);
+    if (QueueOverflowError == NULL) {
+        return NULL;
+    }
+
+    Py_INCREF(QueueOverflowError);
+    if (PyModule_AddObject(m, "QueueOverflowError", QueueOverflowError) < 0) {
+        return NULL;
+    }
+
     return m;
 }
@@ -0,0 +1,89 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef STATE_HPP
+#define STATE_HPP
+
+#include <libsaturn.hpp>
+#include <algorithm>
+#include <cstdint>
+
+/// the registers, in the order A B C X Y Z I J PC SP EX IA
+const int REGISTER_COUNT = 12;
+
+/// the words of RAM in the DCPU-16's address space
+const int RAM_WORDS = 0x10000;
+
+/**
+ * a copy of the cpu's registers followed by its RAM, as one block of words
+ */
+struct dcpu_state {
+    std::uint16_t registers[REGISTER_COUNT];
+    std::uint16_t ram[RAM_WORDS];
+};
+
+inline void save_registers(const galaxy::saturn::dcpu& cpu, std::uint16_t* out)
+{
+    out[0] = cpu.A;
+    out[1] = cpu.B;
+    out[2] = cpu.C;
+    out[3] = cpu.X;
+    out[4] = cpu.Y;
+    out[5] = cpu.Z;
+    out[6] = cpu.I;
+    out[7] = cpu.J;
+    out[8] = cpu.PC;
+    out[9] = cpu.SP;
+    out[10] = cpu.EX;
+    out[11] = cpu.IA;
+}
+
+inline void load_registers(galaxy::saturn::dcpu& cpu, const std::uint16_t* in)
+{
+    cpu.A = in[0];
+    cpu.B = in[1];
+    cpu.C = in[2];
+    cpu.X = in[3];
+    cpu.Y = in[4];
+    cpu.Z = in[5];
+    cpu.I = in[6];
+    cpu.J = in[7];
+    cpu.PC = in[8];
+    cpu.SP = in[9];
+    cpu.EX = in[10];
+    cpu.IA = in[11];
+}
+
+inline void save_state(const galaxy::saturn::dcpu& cpu, dcpu_state& state)
+{
+    save_registers(cpu, state.registers);
+    std::copy(cpu.ram.begin(), cpu.ram.end(), state.ram);
+}
+
+inline void load_state(galaxy::saturn::dcpu& cpu, const dcpu_state& state)
+{
+    load_registers(cpu, state.registers);
+    std::copy(state.ram, state.ram + RAM_WORDS, cpu.ram.begin());
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include "decode.hpp"
+#include "operand.hpp"
+#include "trace.hpp"
+
+/**
+ * the value an operand refers to, read without any of the side effects
+ * (such as POP moving SP) that executing it would have; PC reads as the
+ * address after the `length` words of the instruction, as it does when
+ * the instruction runs
+ */
+static std::uint16_t peek_operand(const galaxy::saturn::dcpu& cpu,
+                                  std::uint16_t operand, std::uint16_t next,
+                                  bool is_b, std::uint16_t length)
+{
+    const std::uint16_t registers[] = {
+        cpu.A, cpu.B, cpu.C, cpu.X, cpu.Y, cpu.Z, cpu.I, cpu.J
+    };
+
+    std::uint16_t address;
+    if (operand_address(cpu, operand, next, is_b, address))
+        return cpu.ram[address];
+
+    if (operand < 0x08)
+        return registers[operand];
+
+    switch (operand) {
+    case 0x1b:
+        return cpu.SP;
+    case 0x1c:
+        return static_cast<std::uint16_t>(cpu.PC + length);
+    case 0x1d:
+        return cpu.EX;
+    case 0x1f:
+        return next;
+    default:
+        // the inline literals -1 to 30
+        return static_cast<std::uint16_t>(operand - 0x21);
+    }
+}
+
+trace_buffer::trace_buffer(std::size_t capacity)
+    : entries(capacity), head(0), count(0), cycle(0), dropped(0)
+{
+}
+
+void trace_buffer::record(const galaxy::saturn::dcpu& cpu, const instruction& ins)
+{
+    trace_entry& entry = entries[head];
+    std::uint16_t pc = cpu.PC;
+
+    entry.cycle = cycle++;
+    entry.pc = pc;
+    entry.words[0] = cpu.ram[pc];
+    entry.words[1] = cpu.ram[static_cast<std::uint16_t>(pc + 1)];
+    entry.words[2] = cpu.ram[static_cast<std::uint16_t>(pc + 2)];
+
+    entry.length = instruction_length(ins);
+
+    // a's next word comes before b's
+    bool a_next = uses_next_word(ins.a);
+    entry.a = peek_operand(cpu, ins.a, entry.words[1], false, entry.length);
+    entry.b = ins.opcode == 0 ? 0 :
+        peek_operand(cpu, ins.b, entry.words[a_next ? 2 : 1], true, entry.length);
+
+    head = (head + 1) % entries.size();
+    if (count == entries.size()) {
+        dropped++;
+    } else {
+        count++;
+    }
+}
+
+std::uint64_t trace_buffer::drain(std::vector<trace_entry>& out)
+{
+    std::size_t start = (head + entries.size() - count) % entries.size();
+
+    out.reserve(out.size() + count);
+    for (std::size_t i = 0; i < count; i++) {
+        out.push_back(entries[(start + i) % entries.size()]);
+    }
+
+    count = 0;
+
+    std::uint64_t overwritten = dropped;
+    dropped = 0;
+    return overwritten;
+}
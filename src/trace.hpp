@@ -0,0 +1,88 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <libsaturn.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "decode.hpp"
+
+/**
+ * one executed instruction, as seen just before it ran
+ */
+struct trace_entry {
+    /// the number of instructions traced before this one
+    std::uint64_t cycle;
+
+    /// the address of the instruction
+    std::uint16_t pc;
+
+    /// the instruction word and the two words after it
+    std::uint16_t words[3];
+
+    /// the value of operand a before the instruction ran
+    std::uint16_t a;
+
+    /// the value of operand b before the instruction ran
+    std::uint16_t b;
+
+    /// how many of `words` belong to the instruction
+    std::uint16_t length;
+};
+
+/**
+ * a fixed size ring buffer of trace entries, keeping the most recent ones
+ */
+class trace_buffer {
+public:
+    explicit trace_buffer(std::size_t capacity);
+
+    /// records `ins`, decoded from the cpu's PC and about to run
+    void record(const galaxy::saturn::dcpu& cpu, const instruction& ins);
+
+    /**
+     * moves the buffered entries, oldest first, into `out`, returning how
+     * many were overwritten since the last drain
+     */
+    std::uint64_t drain(std::vector<trace_entry>& out);
+
+private:
+    std::vector<trace_entry> entries;
+
+    /// where the next entry will be written
+    std::size_t head;
+
+    /// how many entries are waiting to be drained
+    std::size_t count;
+
+    std::uint64_t cycle;
+
+    /// the number of entries overwritten since the last drain
+    std::uint64_t dropped;
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#include <algorithm>
+
+#include "decode.hpp"
+#include "operand.hpp"
+#include "watch.hpp"
+
+/// the basic opcodes that assign b without reading it: SET, STI and STD
+static bool overwrites_b(std::uint16_t opcode)
+{
+    return opcode == 0x01 || opcode == 0x1e || opcode == 0x1f;
+}
+
+/// the special opcodes that assign a: IAG and HWN
+static bool writes_special_a(std::uint16_t opcode)
+{
+    return opcode == 0x09 || opcode == 0x10;
+}
+
+watch_set::watch_set()
+    : pages(0)
+{
+    std::fill(flags, flags + 0x10000, 0);
+}
+
+void watch_set::set(std::uint16_t begin, std::uint32_t count, std::uint8_t kinds)
+{
+    std::uint32_t end = std::min<std::uint32_t>(begin + count, 0x10000);
+    std::fill(flags + begin, flags + end, kinds);
+
+    // recompute the bits of every page the range touched
+    for (std::uint32_t page = begin / WATCH_PAGE_WORDS;
+            page * WATCH_PAGE_WORDS < end; page++) {
+        const std::uint8_t *first = flags + page * WATCH_PAGE_WORDS;
+        bool any = std::find_if(first, first + WATCH_PAGE_WORDS,
+            [](std::uint8_t f) { return f != 0; }) != first + WATCH_PAGE_WORDS;
+
+        if (any) {
+            pages |= std::uint64_t(1) << page;
+        } else {
+            pages &= ~(std::uint64_t(1) << page);
+        }
+    }
+}
+
+bool watch_set::match(const galaxy::saturn::dcpu& cpu, const instruction& ins,
+                      watch_hit& hit) const
+{
+    std::uint16_t pc = cpu.PC;
+
+    // a's next word comes before b's
+    std::uint16_t a_next = cpu.ram[static_cast<std::uint16_t>(pc + 1)];
+    std::uint16_t b_next = cpu.ram[static_cast<std::uint16_t>(pc + 1 + uses_next_word(ins.a))];
+
+    // at most four memory accesses: operands a and b, or the two words
+    // moved by JSR and RFI
+    std::uint16_t addresses[4];
+    std::uint8_t kinds[4];
+    int count = 0;
+
+    std::uint16_t address;
+    if (operand_address(cpu, ins.a, a_next, false, address)) {
+        addresses[count] = address;
+        kinds[count++] = ins.opcode == 0 && writes_special_a(ins.b) ? WATCH_WRITE : WATCH_READ;
+    }
+
+    if (ins.opcode != 0) {
+        if (operand_address(cpu, ins.b, b_next, true, address)) {
+            addresses[count] = address;
+            if (ins.opcode >= OPCODE_IFB && ins.opcode <= OPCODE_IFU) {
+                kinds[count++] = WATCH_READ;
+            } else if (overwrites_b(ins.opcode)) {
+                kinds[count++] = WATCH_WRITE;
+            } else {
+                kinds[count++] = WATCH_ACCESS;
+            }
+        }
+    } else if (ins.b == SPECIAL_JSR) {
+        addresses[count] = cpu.SP - 1;
+        kinds[count++] = WATCH_WRITE;
+    } else if (ins.b == SPECIAL_RFI) {
+        addresses[count] = cpu.SP;
+        kinds[count++] = WATCH_READ;
+        addresses[count] = cpu.SP + 1;
+        kinds[count++] = WATCH_READ;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (watched(addresses[i], kinds[i])) {
+            hit.address = addresses[i];
+            hit.old_value = cpu.ram[addresses[i]];
+            hit.pc = pc;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,96 @@
+/*
+
+This file is part of galaxpy.
+
+galaxpy is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+galaxpy is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with galaxpy.  If not, see <http://www.gnu.org/licenses/>.
+
+Your copy of the GNU Lesser General Public License should be in the
+file named "LICENSE-LGPL.txt".
+
+*/
+
+
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include <libsaturn.hpp>
+#include <cstdint>
+
+#include "decode.hpp"
+
+/// the kinds of access a watchpoint can trap
+enum watch_kind {
+    WATCH_READ = 1,
+    WATCH_WRITE = 2,
+    WATCH_ACCESS = WATCH_READ | WATCH_WRITE
+};
+
+/// the words of RAM covered by each bit of the page bitmap
+const int WATCH_PAGE_WORDS = 0x400;
+
+/// a watched access made by an instruction
+struct watch_hit {
+    /// the address that was accessed
+    std::uint16_t address;
+
+    /// the word at `address` before the instruction ran
+    std::uint16_t old_value;
+
+    /// the word at `address` after the instruction ran
+    std::uint16_t new_value;
+
+    /// the address of the instruction that made the access
+    std::uint16_t pc;
+};
+
+/**
+ * the watched addresses of a cpu, with a bitmap of the pages holding any
+ * of them so that unwatched accesses only cost a bit test
+ */
+class watch_set {
+public:
+    watch_set();
+
+    /// sets what is watched for `count` words from `begin`, 0 clearing them
+    void set(std::uint16_t begin, std::uint32_t count, std::uint8_t kinds);
+
+    /// whether nothing at all is watched
+    bool empty() const { return pages == 0; }
+
+    /**
+     * finds the first watched access `ins`, decoded from the cpu's PC, is
+     * about to make, filling in everything in `hit` but `new_value`.
+     *
+     * Should the cycle take a queued interrupt instead, which cannot be
+     * told for sure from outside libsaturn, the hit is still reported for
+     * that cycle, before `ins` has actually made the access.
+     */
+    bool match(const galaxy::saturn::dcpu& cpu, const instruction& ins,
+               watch_hit& hit) const;
+
+private:
+    bool watched(std::uint16_t address, std::uint8_t kinds) const
+    {
+        return ((pages >> (address / WATCH_PAGE_WORDS)) & 1) &&
+            (flags[address] & kinds);
+    }
+
+    /// one bit for each page with a watched word in it
+    std::uint64_t pages;
+
+    /// the watch_kinds set on each word
+    std::uint8_t flags[0x10000];
+};
+
+#endif
@@ -1,3 +1,6 @@
+import array
+import asyncio
+import threading
 import unittest
 from galaxpy import saturn
 
@@ -10,6 +13,106 @@ class TestDevice(saturn.device):
         print("Cycled")
 
 
+class CountingDevice(saturn.device):
+    cycles = 0
+
+    def cycle(self):
+        self.cycles += 1
+
+
+class TickingDevice(saturn.device):
+    def __init__(self):
+        super().__init__()
+        self.ticks = []
+
+    def cycle(self, elapsed):
+        self.ticks.append(elapsed)
+
+
+class InterruptedDevice(saturn.device):
+    def __init__(self, cpu):
+        super().__init__()
+        self.cpu = cpu
+        self.seen = []
+
+    def interrupt(self):
+        self.seen.append(self.cpu.A)
+
+
+class AnsweringDevice(saturn.device):
+    """answers interrupts by writing to the cpu it is attached to"""
+    def __init__(self, cpu):
+        super().__init__()
+        self.cpu = cpu
+
+    def interrupt(self):
+        self.cpu.B = 0x1234
+        registers = self.cpu.registers
+        registers[2] = 0x4321
+        self.cpu.registers = registers
+        self.cpu[0x100:0x102] = [self.cpu.A, 0x5678]
+
+
+class ReentrantDevice(saturn.device):
+    """tries to run or reset the cpu from inside its own cycle"""
+    def __init__(self, cpu):
+        super().__init__()
+        self.cpu = cpu
+        self.errors = []
+
+    def cycle(self):
+        for action in (lambda: self.cpu.run(10), self.cpu.cycle, self.cpu.reset):
+            try:
+                action()
+            except RuntimeError as e:
+                self.errors.append(e)
+
+
+class RacingDevice(saturn.device):
+    """tries to run the cpu from another thread while it is stopped inside the device"""
+    def __init__(self, cpu):
+        super().__init__()
+        self.cpu = cpu
+        self.errors = []
+
+    def race(self):
+        try:
+            self.cpu.run(200000)
+        except RuntimeError as e:
+            self.errors.append(e)
+
+    def cycle(self):
+        thread = threading.Thread(target=self.race)
+        thread.start()
+        thread.join()
+
+
+class UninitialisedDevice(saturn.device):
+    """never calls saturn.device.__init__"""
+    def __init__(self):
+        self.cycles = 0
+
+    def cycle(self):
+        self.cycles += 1
+
+
+class StaticDevice(saturn.device):
+    calls = []
+
+    @staticmethod
+    def interrupt():
+        StaticDevice.calls.append('interrupt')
+
+    @classmethod
+    def cycle(cls):
+        cls.calls.append('cycle')
+
+
+class FailingDevice(saturn.device):
+    def cycle(self):
+        1 / 0
+
+
 class TestDevices(unittest.TestCase):
     def setUp(self):
         self.cpu = saturn.dcpu()
@@ -20,6 +123,137 @@ class TestDevices(unittest.TestCase):
         self.cpu.attach_device(self.device)
         self.cpu.reset()
 
+    def test_cycle(self):
+        counter = CountingDevice()
+
+        self.cpu.attach_device(counter)
+        self.cpu.attach_device(saturn.device())
+
+        # SUB PC, 1
+        self.cpu.flash([0x8b83])
+        self.cpu.run(10)
+
+        self.assertEqual(counter.cycles, 10)
+
+    def test_tick_period(self):
+        ticker = TickingDevice()
+        ticker.tick_period = 4
+
+        self.cpu.attach_device(ticker)
+
+        # SUB PC, 1
+        self.cpu.flash([0x8b83])
+        self.cpu.run(10)
+
+        self.assertEqual(ticker.ticks, [4, 4])
+
+        with self.assertRaises(ValueError):
+            ticker.tick_period = 0
+
+    def test_gil_handoff(self):
+        self.assertTrue(saturn.device().native)
+        self.assertTrue(saturn.clock().native)
+        self.assertFalse(CountingDevice().native)
+
+        device = InterruptedDevice(self.cpu)
+        self.cpu.attach_device(saturn.device())
+        self.cpu.attach_device(device)
+
+        # SET A, 1 / HWI 1 / HWI 1 / SUB PC, 1
+        self.cpu.flash([0x8801, 0x8a40, 0x8a40, 0x8b83])
+        self.assertEqual(self.cpu.run(10).gil_acquisitions, 2)
+        self.assertEqual(device.seen, [1, 1])
+
+        # only cycles that reach the python device take the GIL
+        ticker = TickingDevice()
+        ticker.tick_period = 4
+        self.cpu.attach_device(ticker)
+        self.assertEqual(self.cpu.run(10).gil_acquisitions, 2)
+
+        self.cpu.attach_device(FailingDevice())
+        with self.assertRaises(ZeroDivisionError):
+            self.cpu.run(10)
+
+    def test_device_writes(self):
+        self.cpu.attach_device(AnsweringDevice(self.cpu))
+
+        # SET A, 7 / HWI 0 / SUB PC, 1
+        self.cpu.flash([0xa001, 0x8640, 0x8b83])
+        self.cpu.run(10)
+
+        self.assertEqual((self.cpu.B, self.cpu.C), (0x1234, 0x4321))
+        self.assertEqual(list(self.cpu[0x100:0x102]), [7, 0x5678])
+
+    def test_callback_lookup(self):
+        class PlainDevice(saturn.device):
+            pass
+
+        # SUB PC, 1
+        self.cpu.flash([0x8b83])
+
+        # callbacks set on the instance are used from the next run
+        device = PlainDevice()
+        self.cpu.attach_device(device)
+        self.assertTrue(device.native)
+
+        cycles = []
+        device.cycle = lambda: cycles.append(1)
+        self.assertFalse(device.native)
+        self.cpu.run(3)
+        self.assertEqual(len(cycles), 3)
+
+        del device.cycle
+        self.cpu.run(3)
+        self.assertEqual(len(cycles), 3)
+
+        # as are callbacks patched onto the class
+        PlainDevice.cycle = lambda self: cycles.append(2)
+        self.cpu.run(3)
+        self.assertEqual(cycles[3:], [2] * 3)
+
+        uninitialised = UninitialisedDevice()
+        self.cpu.attach_device(uninitialised)
+        self.cpu.run(3)
+        self.assertEqual(uninitialised.cycles, 3)
+
+    def test_static_callbacks(self):
+        self.cpu.attach_device(StaticDevice())
+
+        # HWI 0 / SUB PC, 1
+        self.cpu.flash([0x8640, 0x8b83])
+        self.cpu.run(4)
+
+        self.assertIn('interrupt', StaticDevice.calls)
+        self.assertIn('cycle', StaticDevice.calls)
+
+    def test_reentrant_run(self):
+        device = ReentrantDevice(self.cpu)
+        self.cpu.attach_device(device)
+
+        # SET A, 1 / SUB PC, 1
+        self.cpu.flash([0x8801, 0x8b83])
+        self.assertEqual(self.cpu.run(2).cycles, 2)
+        self.cpu.cycle()
+
+        self.assertEqual(len(device.errors), 9)
+        self.assertEqual(self.cpu.A, 1)
+        self.assertEqual(self.cpu.PC, 1)
+
+    def test_run_from_another_thread_inside_device(self):
+        device = RacingDevice(self.cpu)
+        self.cpu.attach_device(device)
+
+        # SUB PC, 1
+        self.cpu.flash([0x8b83])
+        self.assertEqual(self.cpu.run(3).cycles, 3)
+        self.assertEqual(len(device.errors), 3)
+
+    def test_device_error(self):
+        self.cpu.attach_device(FailingDevice())
+
+        with self.assertRaises(ZeroDivisionError):
+            self.cpu.cycle()
+
     def tearDown(self):
         self.cpu.reset()
         del self.device
@@ -49,6 +283,225 @@ class TestDevices(unittest.TestCase):
         )
 
 
+class TestNativeDevices(unittest.TestCase):
+    def setUp(self):
+        self.cpu = saturn.dcpu()
+
+    def test_keyboard(self):
+        keyboard = saturn.keyboard()
+        self.cpu.attach_device(keyboard)
+        keyboard.type("a")
+
+        # SET A, 1 / HWI 0 / SUB PC, 1
+        self.cpu.flash([0x8801, 0x8640, 0x8b83])
+        self.cpu.run(3)
+
+        self.assertEqual(self.cpu.C, ord("a"))
+
+    def test_clock(self):
+        clock = saturn.clock()
+        self.cpu.attach_device(clock)
+
+        # SET A, 0 / SET B, 1 / HWI 0 / SUB PC, 1
+        self.cpu.flash([0x8401, 0x8821, 0x8640, 0x8b83])
+        self.cpu.run(clock.rate // 6)
+
+        self.assertIn(clock.ticks, range(9, 11))
+
+    def test_skip_idle(self):
+        # start the clock at 60Hz with message 1, count ticks in X from an
+        # interrupt handler and spin with SUB PC, 1 in between
+        program = [0x8401, 0x8821, 0x8640, 0x8c01, 0x8821, 0x8640,
+                   0x7d40, 10, 0x8461, 0x8b83, 0x8862, 0x8560]
+
+        results = []
+        for skip_idle in (False, True):
+            cpu = saturn.dcpu()
+            clock = saturn.clock()
+            cpu.attach_device(clock)
+            cpu.flash(program)
+
+            result = cpu.run(clock.rate, skip_idle=skip_idle)
+            results.append((result.cycles, cpu.X, cpu.PC, clock.ticks))
+
+        self.assertEqual(results[0], results[1])
+        self.assertIn(results[1][1], range(59, 61))
+        self.assertGreater(result.skipped, clock.rate // 2)
+
+    def test_lem1802(self):
+        monitor = saturn.lem1802()
+        self.cpu.attach_device(monitor)
+
+        # SET A, 5 / SET B, 0x1000 / HWI 0 / SUB PC, 1
+        self.cpu.flash([0x9801, 0x7c21, 0x1000, 0x8640, 0x8b83])
+        self.cpu.run(4)
+
+        self.assertEqual(self.cpu[0x1000], 0x0000)
+        self.assertEqual(self.cpu[0x100f], 0x0fff)
+
+    def test_lem1802_render(self):
+        monitor = saturn.lem1802()
+        self.cpu.attach_device(monitor)
+
+        # SET A, 0 / SET B, 0x8000 / HWI 0 / SUB PC, 1
+        self.cpu.flash([0x8401, 0x7c21, 0x8000, 0x8640, 0x8b83])
+        self.cpu.run(4)
+
+        # a white on blue full block in the top left cell
+        self.cpu[0x8000] = 0xf11f
+
+        frame = bytearray(128 * 96 * 3)
+        self.assertTrue(monitor.render(frame))
+        self.assertEqual(frame[:3], b'\xff\xff\xff')
+        self.assertEqual(frame[4 * 3:5 * 3], b'\x00\x00\x00')
+
+        self.assertFalse(monitor.render(frame))
+        self.assertTrue(monitor.render(frame, force=True))
+
+        framed = bytearray(130 * 98 * 4)
+        self.assertTrue(monitor.render(framed, border=1))
+        self.assertEqual(framed[:4], b'\x00\x00\x00\xff')
+
+        with self.assertRaises(ValueError):
+            monitor.render(bytearray(10))
+
+        # blinking only redraws the screen when some cell blinks
+        monitor.render(frame)
+        blink = monitor.blink
+        self.cpu.run(50000)
+        self.assertNotEqual(monitor.blink, blink)
+        self.assertFalse(monitor.render(frame))
+
+        self.cpu[0x8001] = 0xf1a0
+        self.assertTrue(monitor.render(frame))
+        self.cpu.run(50000)
+        self.assertTrue(monitor.render(frame))
+
+        async def render_while_running():
+            future = self.cpu.run_async(2 ** 63)
+            with self.assertRaises(RuntimeError):
+                monitor.render(frame)
+
+            future.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await future
+
+        asyncio.run(render_while_running())
+
+    def test_m35fd(self):
+        drive = saturn.m35fd()
+        self.cpu.attach_device(drive)
+        drive.insert(array.array('H', [1, 2, 3]))
+
+        # SET A, 2 / SET X, 0 / SET Y, 0x1000 / HWI 0 / SUB PC, 1
+        self.cpu.flash([0x8c01, 0x8461, 0x7c81, 0x1000, 0x8640, 0x8b83])
+        self.cpu.run(5000)
+
+        self.assertEqual(list(self.cpu[0x1000:0x1003]), [1, 2, 3])
+        self.assertEqual(drive.state, 1)
+
+        drive.eject()
+        self.assertIsNone(drive.disk)
+
+    def test_m35fd_images(self):
+        drive = saturn.m35fd()
+
+        # images follow the rules of flash()
+        drive.insert(bytes([1, 2, 3]))
+        self.assertEqual(list(drive.disk[:4]), [1, 2, 3, 0])
+        drive.insert(b'\x12\x34', byteorder='big')
+        self.assertEqual(drive.disk[0], 0x1234)
+        drive.insert(array.array('I', [0x1234, 5]))
+        self.assertEqual(list(drive.disk[:2]), [0x1234, 5])
+        drive.insert(memoryview(array.array('H', [6, 0, 7]))[::2])
+        self.assertEqual(list(drive.disk[:2]), [6, 7])
+
+        with self.assertRaises(OverflowError):
+            drive.insert(array.array('I', [0x10000]))
+        with self.assertRaises(ValueError):
+            drive.insert(b'\x01', byteorder='little')
+        with self.assertRaises(ValueError):
+            drive.insert(bytes(1440 * 512 + 1))
+
+    def test_m35fd_while_running(self):
+        drive = saturn.m35fd()
+        self.cpu.attach_device(drive)
+        self.cpu.flash([0x8b83])  # SUB PC, 1
+
+        async def swap_disks():
+            future = self.cpu.run_async(2 ** 63)
+            with self.assertRaises(RuntimeError):
+                drive.insert([1, 2, 3])
+            with self.assertRaises(RuntimeError):
+                drive.eject()
+
+            future.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await future
+
+        asyncio.run(swap_disks())
+        self.assertIsNone(drive.disk)
+
+        drive.insert([1, 2, 3])
+        self.assertEqual(drive.state, 1)
+
+    def test_attach_once(self):
+        monitor = saturn.lem1802()
+        self.cpu.attach_device(monitor)
+
+        with self.assertRaises(ValueError):
+            self.cpu.attach_device(monitor)
+        with self.assertRaises(ValueError):
+            saturn.dcpu().attach_device(monitor)
+
+    def test_reinit(self):
+        clock = saturn.clock()
+        clock.__init__(rate=1000)
+        self.assertEqual(clock.rate, 1000)
+
+        self.cpu.attach_device(clock)
+        with self.assertRaises(RuntimeError):
+            clock.__init__(rate=10)
+        self.assertEqual(clock.rate, 1000)
+
+        device = CountingDevice()
+        device.__init__()
+        self.cpu.attach_device(device)
+        with self.assertRaises(RuntimeError):
+            device.__init__()
+
+        # native devices are usable even if a subclass skips their __init__
+        class QuietClock(saturn.clock):
+            def __init__(self):
+                pass
+
+        self.assertEqual(QuietClock().rate, 100000)
+
+    def test_device_outlives_cpu(self):
+        cpu = saturn.dcpu()
+        monitor = saturn.lem1802()
+        drive = saturn.m35fd()
+        cpu.attach_device(monitor)
+        cpu.attach_device(drive)
+
+        # SET A, 1 / SET X, 0x10 / HWI 1 / SET A, 0 / SET B, 0x8000 / HWI 0 / SUB PC, 1
+        cpu.flash([0x8801, 0xc461, 0x8a40, 0x8401, 0x7c21, 0x8000, 0x8640, 0x8b83])
+        cpu[0x8000] = 0xf11f
+        cpu.run(30)
+        self.assertEqual(monitor.screen, 0x8000)
+        del cpu
+
+        # neither device touches the freed cpu any more
+        frame = bytearray(128 * 96 * 3)
+        self.assertTrue(monitor.render(frame))
+        self.assertEqual(frame, bytes(len(frame)))
+        drive.insert([1, 2, 3])
+        self.assertEqual(drive.state, 1)
+
+        # and they can be attached to a new one
+        saturn.dcpu().attach_device(drive)
+
+
 def main():
     unittest.main()
 
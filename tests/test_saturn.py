@@ -1,4 +1,10 @@
+import array
+import asyncio
+import gc
+import pickle
+import signal
 import unittest
+import weakref
 from galaxpy import saturn
 
 class TestSaturn(unittest.TestCase):
@@ -25,7 +31,504 @@ class TestSaturn(unittest.TestCase):
         )
 
         self.cpu.reset()
-        
+
+    def test_flash_buffers(self):
+        opcodes = array.array('H', [0x7c01, 0x0f00, 0x7fc1])
+
+        self.cpu.flash(opcodes)
+        self.assertEqual(self.cpu[:3], opcodes)
+
+        self.cpu.flash(b'\x7c\x01\x0f\x00', byteorder='big', offset=0x100)
+        self.assertEqual(list(self.cpu[0x100:0x102]), [0x7c01, 0x0f00])
+
+        self.cpu.flash(b'\x01\x7c', byteorder='little', offset=0x200)
+        self.assertEqual(self.cpu[0x200], 0x7c01)
+
+        # without a byteorder, bytes hold one word per item
+        self.cpu.flash(b'\x01\x02', offset=0x300)
+        self.assertEqual(list(self.cpu[0x300:0x302]), [1, 2])
+
+        # strided buffers are gathered rather than refused
+        self.cpu.flash(memoryview(array.array('H', [1, 0, 2, 0, 3]))[::2], offset=0x400)
+        self.assertEqual(list(self.cpu[0x400:0x403]), [1, 2, 3])
+        self.cpu.flash(memoryview(b'\x04\x00\x05')[::2], offset=0x500)
+        self.assertEqual(list(self.cpu[0x500:0x502]), [4, 5])
+
+        with self.assertRaises(ValueError):
+            self.cpu.flash(opcodes, offset=0xffff)
+
+        self.cpu.reset()
+
+    def test_buffer(self):
+        ram = memoryview(self.cpu)
+
+        self.assertEqual(ram.format, 'H')
+        self.assertEqual(ram.shape, (0x10000,))
+        self.assertFalse(ram.readonly)
+
+        ram[0x8000] = 0xf041
+        self.assertEqual(self.cpu[0x8000], 0xf041)
+
+        self.cpu[0x8001] = 0x1234
+        self.assertEqual(ram[0x8001], 0x1234)
+
+        ram.release()
+        self.cpu.reset()
+
+    def test_slices(self):
+        self.cpu[0x8000:0x8004] = [1, 2, 3, 4]
+
+        self.assertEqual(
+            self.cpu[0x8000:0x8004],
+            array.array('H', [1, 2, 3, 4])
+        )
+        self.assertEqual(list(self.cpu[0x8000:0x8004:2]), [1, 3])
+        self.assertEqual(self.cpu[-0x8000], 1)
+
+        self.cpu[0x8000:0x8002] = array.array('H', [0xdead, 0xbeef])
+        self.assertEqual(list(self.cpu[0x8000:0x8004]), [0xdead, 0xbeef, 3, 4])
+
+        self.cpu[0x8001:0x8004:2] = self.cpu[0:2]
+        self.assertEqual(list(self.cpu[0x8000:0x8004]), [0xdead, 0, 3, 0])
+
+        with self.assertRaises(ValueError):
+            self.cpu[0:2] = [1, 2, 3]
+
+        # buffers follow the rules of flash(): bytes give one word each,
+        # other item types are read as integers rather than as raw memory
+        self.cpu[0:4] = bytes([1, 2, 3, 4])
+        self.assertEqual(list(self.cpu[0:4]), [1, 2, 3, 4])
+        self.cpu[0:1] = array.array('I', [0x1234])
+        self.assertEqual(self.cpu[0], 0x1234)
+        with self.assertRaises(OverflowError):
+            self.cpu[0:1] = array.array('I', [0x10000])
+        with self.assertRaises(ValueError):
+            self.cpu[0:2] = b'\x01\x00\x02\x00'
+        self.cpu[0:2] = memoryview(array.array('H', [5, 0, 6]))[::2]
+        self.assertEqual(list(self.cpu[0:2]), [5, 6])
+
+        self.cpu.reset()
+
+    def test_snapshot(self):
+        self.cpu.flash([1, 2, 3])
+        self.cpu.A = 0x1234
+        self.cpu.PC = 2
+
+        state = self.cpu.snapshot()
+
+        self.cpu.reset()
+        self.cpu.restore(state)
+
+        self.assertEqual(self.cpu.A, 0x1234)
+        self.assertEqual(self.cpu.PC, 2)
+        self.assertEqual(list(self.cpu[:3]), [1, 2, 3])
+
+        words = memoryview(state)
+        self.assertTrue(words.readonly)
+        self.assertEqual(words[0], 0x1234)
+        self.assertEqual(words[12:15].tolist(), [1, 2, 3])
+
+        copy = pickle.loads(pickle.dumps(state))
+        self.assertEqual(bytes(copy), bytes(state))
+
+        # interrupts queued since the snapshot are not carried over
+        self.cpu.IA = 0x10
+        self.cpu.PC = 0
+        self.cpu.flash([0x8802] * 4)
+        state = self.cpu.snapshot()
+        self.cpu.interrupt(1)
+        self.cpu.restore(state)
+        self.cpu.cycle()
+        self.assertEqual(self.cpu.PC, 1)
+
+        self.cpu.reset()
+
+    def test_run(self):
+        # ADD A, 1 / SUB PC, 2
+        self.cpu.flash([0x8802, 0x8f83])
+
+        result = self.cpu.run(100)
+
+        self.assertEqual(result.cycles, 100)
+        self.assertEqual(result.reason, saturn.STOP_BUDGET)
+        self.assertGreater(self.cpu.A, 0)
+
+        self.cpu.reset()
+
+    def test_run_until(self):
+        # SET A, 2 / ADD A, 1 / SUB PC, 1
+        self.cpu.flash([0x8c01, 0x8802, 0x8b83])
+
+        result = self.cpu.run_until(breakpoints={1})
+        self.assertEqual(result.reason, saturn.STOP_BREAKPOINT)
+        self.assertEqual(result.pc, 1)
+        self.assertEqual(self.cpu.A, 2)
+
+        result = self.cpu.run_until(stop_on_idle=True, cycles=1000)
+        self.assertEqual(result.reason, saturn.STOP_IDLE)
+        self.assertEqual(result.pc, 2)
+        self.assertEqual(self.cpu.A, 3)
+
+        result = self.cpu.run_until(cycles=10)
+        self.assertEqual(result.reason, saturn.STOP_BUDGET)
+        self.assertEqual(result.cycles, 10)
+
+        self.cpu.reset()
+
+    def test_batch(self):
+        cpus = [saturn.dcpu() for i in range(8)]
+        for i, cpu in enumerate(cpus):
+            # SET A, 1 / ADD A, 1 / SUB PC, 1 or SUB PC, 2
+            cpu.flash([0x8801, 0x8802, 0x8b83 if i % 2 else 0x8f83])
+
+        results = saturn.batch(cpus, 100, threads=3)
+
+        self.assertEqual(len(results), 8)
+        for i, result in enumerate(results):
+            self.assertEqual(result.reason, saturn.STOP_BUDGET)
+            self.assertEqual(result.cycles, 100)
+            self.assertEqual(cpus[i].A == 2, bool(i % 2))
+
+        with self.assertRaises(ValueError):
+            saturn.batch([cpus[0], cpus[0]], 10)
+
+    def test_registers(self):
+        cpu = saturn.dcpu()
+        cpu.set_registers(range(1, 13))
+        self.assertEqual(cpu.X, 4)
+        self.assertEqual(cpu.IA, 12)
+        self.assertEqual(list(cpu.get_registers()), list(range(1, 13)))
+
+        registers = cpu.registers
+        registers[8] = 0x1234
+        cpu.registers = registers
+        self.assertEqual(cpu.PC, 0x1234)
+
+        with self.assertRaises(ValueError):
+            cpu.registers = [0] * 11
+        with self.assertRaises(ValueError):
+            cpu.registers = bytes(24)
+        cpu.registers = bytes(range(12))
+        self.assertEqual(cpu.IA, 11)
+        cpu.registers = array.array('I', range(12, 24))
+        self.assertEqual(cpu.A, 12)
+
+        async def assign_while_running():
+            cpu.flash([0x8b83])
+            future = cpu.run_async(2 ** 63)
+            with self.assertRaises(RuntimeError):
+                cpu.registers = registers
+            future.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await future
+
+        asyncio.run(assign_while_running())
+
+    def test_trace(self):
+        cpu = saturn.dcpu()
+        # SET B, 0x1234 / ADD A, B / SUB PC, 1
+        cpu.flash([0x7c21, 0x1234, 0x0402, 0x8b83])
+        cpu.start_trace(capacity=4)
+
+        cpu.cycle()
+        cpu.run(5)
+
+        trace = cpu.drain_trace()
+        self.assertEqual(len(trace), 4)
+        self.assertEqual(trace.dropped, 2)
+        self.assertEqual(memoryview(trace).itemsize, 24)
+        # PC reads as the address after the instruction
+        self.assertEqual(trace[0], (2, 3, (0x8b83,), 1, 4))
+
+        cpu.stop_trace()
+        cpu.start_trace()
+        cpu.PC = 0
+        cpu.run(2)
+        self.assertEqual(list(cpu.drain_trace()), [
+            (0, 0, (0x7c21, 0x1234), 0x1234, 0x1234),
+            (1, 2, (0x0402,), 0x1234, 0x1234),
+        ])
+        self.assertEqual(len(cpu.drain_trace()), 0)
+
+    def test_profile(self):
+        cpu = saturn.dcpu()
+        # SET B, 0x1234 / ADD A, B / SUB PC, 1
+        cpu.flash([0x7c21, 0x1234, 0x0402, 0x8b83])
+        cpu.profile = profile = saturn.profile()
+
+        cpu.cycle()
+        cpu.run(4)
+
+        self.assertEqual(profile.opcode_counts[0x01], 1)
+        self.assertEqual(profile.opcode_counts[0x03], 3)
+        self.assertEqual(profile.opcode_cycles[0x01], 2)
+        self.assertEqual(profile.opcode_cycles[0x02], 2)
+        self.assertEqual(list(profile.pc_counts[:4]), [1, 0, 1, 3])
+        self.assertEqual(profile.fold({'start': 0, 'loop': 3}),
+                         {'start': 2, 'loop': 3})
+
+        with self.assertRaises(ValueError):
+            saturn.dcpu().profile = profile
+
+        profile.reset()
+        self.assertEqual(sum(profile.pc_counts), 0)
+        cpu.profile = None
+        cpu.run(1)
+        self.assertEqual(sum(profile.pc_counts), 0)
+
+    def test_profile_interrupts(self):
+        cpu = saturn.dcpu()
+        # IAS 0x10 / ADD A, 1 / ADD A, 1, with RFI as the handler at 0x10
+        cpu.flash([0x7d40, 0x10, 0x8802, 0x8802])
+        cpu[0x10] = 0x8560
+        cpu.profile = profile = saturn.profile()
+        pc_counts = profile.pc_counts
+
+        cpu.run(2)
+        cpu.interrupt(5)
+        cpu.cycle()
+        self.assertEqual(profile.interrupts, 1)
+        self.assertEqual(cpu.PC, 3)
+        self.assertEqual(cpu.A, 1)
+
+        # the handler ran in place of the instruction at 3
+        self.assertEqual(pc_counts[3], 0)
+        self.assertEqual(pc_counts[0x10], 1)
+        self.assertEqual(profile.opcode_counts[0x20 + 0x0b], 1)
+
+        cpu.run(1)
+        self.assertEqual(pc_counts[3], 1)
+        self.assertEqual(profile.interrupts, 1)
+
+        with self.assertRaises(TypeError):
+            pc_counts[3] = 0
+
+    def test_watch(self):
+        cpu = saturn.dcpu()
+        # SET [0x1000], 5 / SET A, [0x1000] / SUB PC, 1
+        cpu.flash([0x9bc1, 0x1000, 0x7801, 0x1000, 0x8b83])
+        cpu[0x1000] = 3
+
+        cpu.watch(0x1000)
+        result = cpu.run(10)
+        self.assertEqual(result.reason, saturn.STOP_WATCHPOINT)
+        self.assertEqual((result.address, result.old, result.new, result.access_pc),
+                         (0x1000, 3, 5, 0))
+        self.assertEqual(result.pc, 2)
+
+        # writes only, so the read carries on to the end of the budget
+        result = cpu.run(10)
+        self.assertEqual(result.reason, saturn.STOP_BUDGET)
+        self.assertIsNone(result.address)
+
+        cpu.PC = 0
+        cpu.watch(0x1000, kind=saturn.WATCH_READ)
+        cpu.run(1)
+        result = cpu.run(10)
+        self.assertEqual(result.reason, saturn.STOP_WATCHPOINT)
+        self.assertEqual(result.access_pc, 2)
+
+        cpu.unwatch()
+        cpu.PC = 0
+        self.assertEqual(cpu.run(10).reason, saturn.STOP_BUDGET)
+
+    def test_watch_interrupted(self):
+        cpu = saturn.dcpu()
+        # IAS 0x10 / SET [0x1000], 5 / SUB PC, 1, handler ADD X, 1 / RFI
+        cpu.flash([0x7d40, 0x10, 0x9bc1, 0x1000, 0x8b83])
+        cpu[0x10:0x12] = [0x8862, 0x8560]
+        cpu[0x1000] = 3
+        cpu.run(1)
+
+        # the SET is matched as it comes up, even though the handler takes
+        # the cycle and the write has not happened yet
+        cpu.A = 7
+        cpu.interrupt(9)
+        cpu.watch(0x1000)
+        result = cpu.run(10)
+        self.assertEqual(result.reason, saturn.STOP_WATCHPOINT)
+        self.assertEqual(result.cycles, 1)
+        self.assertEqual((result.address, result.old, result.new, result.access_pc),
+                         (0x1000, 3, 3, 2))
+        self.assertEqual(cpu.X, 1)
+
+        # resuming runs the rest of the handler, then the SET itself
+        result = cpu.run(10)
+        self.assertEqual(result.reason, saturn.STOP_WATCHPOINT)
+        self.assertEqual(result.cycles, 2)
+        self.assertEqual((result.address, result.old, result.new, result.access_pc),
+                         (0x1000, 3, 5, 2))
+
+    def test_dirty_ranges(self):
+        cpu = saturn.dcpu()
+        self.assertEqual(cpu.take_dirty_ranges(), [(0, 0x10000)])
+        self.assertEqual(cpu.take_dirty_ranges(), [])
+
+        state = cpu.snapshot()
+        cpu[10:13] = [1, 2, 3]
+        cpu[63:65] = [4, 5]
+        cpu[0xffff] = 6
+
+        ranges = [(10, 13), (63, 65), (0xffff, 0x10000)]
+        self.assertEqual(cpu.diff(state), ranges)
+        self.assertEqual(cpu.take_dirty_ranges(), ranges)
+        self.assertEqual(cpu.take_dirty_ranges(), [])
+
+        cpu.restore(state)
+        self.assertEqual(cpu.take_dirty_ranges(), ranges)
+        self.assertEqual(cpu.diff(state), [])
+
+    def test_run_realtime(self):
+        cpu = saturn.dcpu()
+        cpu.flash([0x8802, 0x8f83])  # ADD A, 1 / SUB PC, 2
+
+        result = cpu.run_realtime(hz=20000, duration=0.05)
+        self.assertEqual(result.run.reason, saturn.STOP_BUDGET)
+        self.assertEqual(result.run.cycles + result.dropped, 1000)
+        self.assertGreaterEqual(result.elapsed, 0.045)
+        self.assertGreater(result.slices, 1)
+
+        with self.assertRaises(ValueError):
+            cpu.run_realtime(hz=20000, duration=float('inf'))
+
+    @unittest.skipUnless(hasattr(signal, 'setitimer'), "needs interval timers")
+    def test_run_realtime_signal(self):
+        cpu = saturn.dcpu()
+        cpu.flash([0x8b83])  # SUB PC, 1
+
+        def alarm(signum, frame):
+            raise KeyboardInterrupt
+
+        previous = signal.signal(signal.SIGALRM, alarm)
+        try:
+            signal.setitimer(signal.ITIMER_REAL, 0.05)
+            with self.assertRaises(KeyboardInterrupt):
+                cpu.run_realtime(hz=20000, duration=10)
+        finally:
+            signal.setitimer(signal.ITIMER_REAL, 0)
+            signal.signal(signal.SIGALRM, previous)
+
+        # the cpu is usable again once the run has been interrupted
+        self.assertEqual(cpu.run(1).cycles, 1)
+
+    def test_run_async(self):
+        async def runs():
+            cpus = [saturn.dcpu() for _ in range(4)]
+            for cpu in cpus:
+                cpu.flash([0x8802, 0x8f83])  # ADD A, 1 / SUB PC, 2
+
+            results = await asyncio.gather(*(cpu.run_async(1000) for cpu in cpus))
+            self.assertEqual([r.cycles for r in results], [1000] * 4)
+            self.assertEqual([cpu.A for cpu in cpus], [500] * 4)
+
+            result = await cpus[0].run_until_async(breakpoints=[1])
+            self.assertEqual(result.reason, saturn.STOP_BREAKPOINT)
+
+            # the run only ends when it is cancelled
+            future = cpus[0].run_async(2 ** 63)
+            with self.assertRaises(RuntimeError):
+                cpus[0].run(1)
+
+            await asyncio.sleep(0.01)
+            future.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await future
+
+            await asyncio.sleep(0.05)
+            self.assertEqual(cpus[0].run(2).cycles, 2)
+
+        asyncio.run(runs())
+
+    def test_write_while_running(self):
+        async def writes():
+            cpu = saturn.dcpu()
+            cpu.flash([0x8b83])  # SUB PC, 1
+            future = cpu.run_async(2 ** 63)
+
+            for write in (lambda: setattr(cpu, 'A', 1), lambda: setattr(cpu, 'IA', 1),
+                          lambda: cpu.__setitem__(0x100, 1),
+                          lambda: cpu.__setitem__(slice(0x100, 0x102), [1, 2])):
+                with self.assertRaises(RuntimeError):
+                    write()
+
+            future.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await future
+
+            self.assertEqual((cpu.A, cpu.IA, cpu[0x100]), (0, 0, 0))
+
+        asyncio.run(writes())
+
+    def test_interrupt_while_running(self):
+        async def runs():
+            cpu = saturn.dcpu()
+            # IAS 3 / SUB PC, 1 / handler: ADD X, 1 / RFI
+            cpu.flash([0x7d40, 3, 0x8b83, 0x8862, 0x8560])
+
+            future = cpu.run_async(2 ** 63)
+            await asyncio.sleep(0.01)
+            cpu.interrupt_many([1] * 10)
+            cpu.interrupt(2)
+            await asyncio.sleep(0.05)
+
+            future.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await future
+            await asyncio.sleep(0.05)
+
+            self.assertEqual(cpu.X, 11)
+
+        asyncio.run(runs())
+
+        cpu = saturn.dcpu()
+        with self.assertRaises(OverflowError):
+            cpu.interrupt_many([0x10000])
+        with self.assertRaises(saturn.QueueOverflowError):
+            cpu.interrupt_many([1] * 300)
+
+    def test_dcpu_array(self):
+        # SET A, 1 / ADD A, 1 / SUB PC, 1
+        lanes = saturn.dcpu_array(4, [0x8801, 0x8802, 0x8b83])
+        self.assertEqual(len(lanes), 4)
+
+        registers = lanes.snapshot_registers()
+        registers[4 * 1 + 2] = 7  # B of lane 2
+        self.assertEqual(lanes[2].B, 0)
+        lanes.restore_registers(registers)
+        self.assertEqual(lanes[2].B, 7)
+        with self.assertRaises(ValueError):
+            lanes.restore_registers(registers[:-1])
+
+        results = lanes.run(10)
+        self.assertEqual([r.reason for r in results], [saturn.STOP_BUDGET] * 4)
+        self.assertEqual(list(lanes.snapshot_registers()[:4]), [2] * 4)
+        self.assertEqual(list(lanes[3][:3]), [0x8801, 0x8802, 0x8b83])
+
+        ram = memoryview(lanes[1])
+        ram[0x8000] = 0x1234
+        self.assertEqual(lanes[1][0x8000], 0x1234)
+        self.assertEqual(lanes[0][0x8000], 0)
+
+    def test_dcpu_array_collected(self):
+        class Owner(saturn.device):
+            def cycle(self):
+                pass
+
+        # a device on a lane that refers back to the array makes a cycle
+        lanes = saturn.dcpu_array(2)
+        owner = Owner()
+        owner.lanes = lanes
+        lanes[1].attach_device(owner)
+
+        # python devices cannot run on the thread pool
+        with self.assertRaises(ValueError):
+            lanes.run(10)
+
+        collected = weakref.ref(owner)
+        del lanes, owner
+        gc.collect()
+        self.assertIsNone(collected())
+
 
 def main():
     unittest.main()